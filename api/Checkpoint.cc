@@ -0,0 +1,135 @@
+/*!
+ * Timetabler Copyright (c) 2019 Alexandre Lemos, Pedro T Monteiro, Ines Lynce
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include "Checkpoint.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+
+bool Checkpoint::save(const std::string &file, std::string &error) const {
+    std::string tmp = file + ".tmp";
+    FILE *out = fopen(tmp.c_str(), "w");
+    if (out == NULL) {
+        error = "Cannot write " + tmp;
+        return false;
+    }
+    fprintf(out, "c timetabler checkpoint 1\n");
+    fprintf(out, "hash %" PRIx64 " vars %d\n", hash, vars);
+    fprintf(out, "config %s\n", config.c_str());
+    if (model.empty())
+        fprintf(out, "bounds %" PRIu64 " -\n", lb);
+    else
+        fprintf(out, "bounds %" PRIu64 " %" PRIu64 "\n", lb, ub);
+    fprintf(out, "phase %" PRIu64 "\n", phase);
+    fprintf(out, "optimum %d\n", optimum ? 1 : 0);
+    if (!model.empty()) {
+        fprintf(out, "model ");
+        for (bool value: model)
+            fputc(value ? '1' : '0', out);
+        fputc('\n', out);
+    }
+    for (const std::vector<int> &clause: learnts) {
+        fprintf(out, "l");
+        for (int lit: clause)
+            fprintf(out, " %d", lit);
+        fprintf(out, " 0\n");
+    }
+    bool ok = fflush(out) == 0 && !ferror(out);
+    ok = fclose(out) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), file.c_str()) != 0) {
+        error = "Cannot write " + file;
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool Checkpoint::load(const std::string &file, std::string &error) {
+    std::ifstream in(file);
+    if (!in) {
+        error = "Cannot read " + file;
+        return false;
+    }
+    *this = Checkpoint();
+    std::string line;
+    if (!std::getline(in, line) || line != "c timetabler checkpoint 1") {
+        error = file + " is not a checkpoint";
+        return false;
+    }
+    bool header = false;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        fields >> key;
+        bool ok = true;
+        if (key == "hash") {
+            std::string vs;
+            ok = bool(fields >> std::hex >> hash >> std::dec >> vs >> vars) && vs == "vars" && vars >= 0;
+            header = ok;
+        } else if (key == "config") {
+            config = line.size() > 7 ? line.substr(7) : "";
+        } else if (key == "bounds") {
+            std::string u;
+            ok = bool(fields >> lb >> u);
+            if (ok && u != "-") {
+                std::istringstream(u) >> ub;
+            }
+        } else if (key == "phase") {
+            ok = bool(fields >> phase);
+        } else if (key == "optimum") {
+            int o;
+            ok = bool(fields >> o);
+            optimum = o == 1;
+        } else if (key == "model") {
+            std::string values;
+            ok = bool(fields >> values) && (int)values.size() == vars &&
+                 values.find_first_not_of("01") == std::string::npos;
+            for (char c: values)
+                model.push_back(c == '1');
+        } else if (key == "l") {
+            std::vector<int> clause;
+            int lit;
+            while ((ok = bool(fields >> lit)) && lit != 0) {
+                if (lit > vars || -lit > vars) {
+                    ok = false;
+                    break;
+                }
+                clause.push_back(lit);
+            }
+            learnts.push_back(clause);
+        } else if (key != "c" && !key.empty()) {
+            ok = false;
+        }
+        if (!ok || !header) {
+            error = file + ": invalid line '" + line.substr(0, 40) + "'";
+            return false;
+        }
+    }
+    if (!header) {
+        error = file + " is not a checkpoint";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+//
+// Checkpoints of a long running search.
+//
+
+#ifndef TRAIN_SCHEDULE_OPTIMISATION_CHECKPOINT_H
+#define TRAIN_SCHEDULE_OPTIMISATION_CHECKPOINT_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// State of a search, enough to resume it in a new process: the best model,
+// the bounds, the phase of the algorithm and a bounded set of learnt clauses
+// (see Timetabler::enableCheckpoints). A checkpoint belongs to one encoding,
+// identified by 'hash' and 'vars'.
+//
+// Text format, one item per line:
+//   c timetabler checkpoint 1
+//   hash <hex> vars <n>
+//   config <algorithm options>
+//   bounds <lb> <ub>          ub is '-' without a model
+//   phase <n>
+//   optimum <0|1>
+//   model <one 0/1 per variable>
+//   l <DIMACS literals> 0     once per learnt clause
+struct Checkpoint {
+    // At most this many learnt clauses, of LBD at most 'maxLBD', are saved.
+    static const int maxLearnts = 20000;
+    static const unsigned int maxLBD = 4;
+
+    uint64_t hash = 0;
+    int vars = 0;
+    std::string config;             // algorithm the phase belongs to
+    uint64_t lb = 0;
+    uint64_t ub = UINT64_MAX;       // cost of 'model'
+    uint64_t phase = 0;             // see MaxSAT::getPhase
+    bool optimum = false;
+    std::vector<bool> model;        // empty without a model
+    std::vector<std::vector<int>> learnts;  // DIMACS literals
+
+    // 'save' writes a temporary file and renames it over 'file', so a crash
+    // leaves the previous checkpoint intact.
+    bool save(const std::string &file, std::string &error) const;
+    bool load(const std::string &file, std::string &error);
+};
+
+#endif //TRAIN_SCHEDULE_OPTIMISATION_CHECKPOINT_H
@@ -0,0 +1,190 @@
+/*!
+ * Timetabler Copyright (c) 2019 Alexandre Lemos, Pedro T Monteiro, Ines Lynce
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef MAXSATNID
+#define MAXSATNID 1
+#endif
+
+#include "ClauseCache.h"
+
+#if MAXSATNID==1
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+using namespace openwbo;
+
+bool ClauseCache::load(const std::string &file, std::string &error) {
+    std::ifstream in(file);
+    if (!in)
+        return true;
+    std::string line;
+    if (!std::getline(in, line) || line != "c timetabler clause cache 1") {
+        error = file + " is not a clause cache";
+        return false;
+    }
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::vector<std::string> clause;
+        std::string lit;
+        while (fields >> lit)
+            clause.push_back(lit);
+        std::sort(clause.begin(), clause.end());
+        if (!clause.empty())
+            clauses.insert(clause);
+    }
+    return true;
+}
+
+static bool shorter(const std::vector<std::string> *a, const std::vector<std::string> *b) {
+    return a->size() < b->size();
+}
+
+bool ClauseCache::save(const std::string &file, std::string &error) const {
+    std::vector<const std::vector<std::string> *> kept;
+    for (const std::vector<std::string> &clause: clauses)
+        kept.push_back(&clause);
+    std::stable_sort(kept.begin(), kept.end(), shorter);
+    if (kept.size() > maxClauses)
+        kept.resize(maxClauses);
+
+    std::string tmp = file + ".tmp";
+    FILE *out = fopen(tmp.c_str(), "w");
+    if (out == NULL) {
+        error = "Cannot write " + tmp;
+        return false;
+    }
+    fprintf(out, "c timetabler clause cache 1\n");
+    for (const std::vector<std::string> *clause: kept) {
+        for (size_t i = 0; i < clause->size(); i++)
+            fprintf(out, i == 0 ? "%s" : " %s", (*clause)[i].c_str());
+        fprintf(out, "\n");
+    }
+    bool ok = fflush(out) == 0 && !ferror(out);
+    ok = fclose(out) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), file.c_str()) != 0) {
+        error = "Cannot write " + file;
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+int ClauseCache::inject(Timetabler &request) {
+    Solver *solver = request.buildSATSolver();
+    int injected = 0;
+    std::set<std::vector<std::string>>::iterator it = clauses.begin();
+    while (it != clauses.end()) {
+        vec<Lit> clause;
+        for (const std::string &lit: *it) {
+            bool negative = lit[0] == '-';
+            std::vector<char> name(lit.begin() + (negative ? 1 : 0), lit.end());
+            name.push_back('\0');
+            int v = request.maxsat_formula->varID(&name[0]);
+            if (v == var_Undef)
+                break;
+            clause.push(mkLit(v, negative));
+        }
+        if ((size_t) clause.size() < it->size()) {// a section of another route
+            it++;
+            continue;
+        }
+
+        vec<Lit> assumptions;
+        for (int i = 0; i < clause.size(); i++)
+            assumptions.push(~clause[i]);
+        solver->setConfBudget(conflictBudget);
+        lbool res = solver->solveLimited(assumptions);
+        if (res == l_True) {// refuted by this instance
+            it = clauses.erase(it);
+            continue;
+        }
+        if (res == l_False) {
+            request.addImpliedClause(clause);
+            solver->addClause(clause);
+            injected++;
+        }
+        it++;
+    }
+    delete solver;
+    return injected;
+}
+
+bool ClauseCache::shared(const std::string &name) {
+    return name.compare(0, 2, "t^") == 0;
+}
+
+std::string ClauseCache::name(Timetabler &request, Lit p) {
+    indexMap::const_iterator it = request.maxsat_formula->getIndexToName().find(var(p));
+    if (it == request.maxsat_formula->getIndexToName().end()) {
+        std::map<int, Lit>::iterator soft = softs.find(toInt(p));
+        if (soft == softs.end())
+            return "";
+        return name(request, soft->second);
+    }
+    if (!shared(it->second))
+        return "";
+    return sign(p) ? "-" + it->second : it->second;
+}
+
+void ClauseCache::add(Timetabler &request, const vec<Lit> &clause) {
+    if (clause.size() == 0 || clauses.size() >= 2 * maxClauses)
+        return;
+    std::vector<std::string> named;
+    for (int i = 0; i < clause.size(); i++) {
+        named.push_back(name(request, clause[i]));
+        if (named.back().empty())
+            return;
+    }
+    std::sort(named.begin(), named.end());
+    clauses.insert(named);
+}
+
+void ClauseCache::collect(Timetabler &request, Solver *solver) {
+    // A core over the assumptions of the soft clauses (l v r) of the
+    // objective, assuming ~r, means that the hard clauses imply ~l1 v ~l2 ...
+    MaxSATFormula *formula = request.S->getMaxSATFormula();
+    for (; mappedSofts < formula->nSoft(); mappedSofts++) {
+        Soft &soft = formula->getSoftClause(mappedSofts);
+        if (soft.assumption_var == lit_Undef)
+            break;
+        if (soft.clause.size() == 1 && soft.relaxation_vars.size() == 1 &&
+            soft.relaxation_vars[0] == soft.assumption_var)
+            softs[toInt(soft.assumption_var)] = ~soft.clause[0];
+    }
+    add(request, solver->conflict);
+
+    // Learnt clauses, at most once per second
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (lastExport >= 0 && now - lastExport < 1)
+        return;
+    lastExport = now;
+    vec<vec<Lit> > learnts;
+    solver->learntClauses(learnts, formula->nInitialVars(), Checkpoint::maxLBD, maxClauses);
+    for (int i = 0; i < learnts.size(); i++)
+        add(request, learnts[i]);
+}
+
+#endif
@@ -0,0 +1,65 @@
+//
+// Learnt clauses and cores reused across related instances.
+//
+
+#ifndef TRAIN_SCHEDULE_OPTIMISATION_CLAUSECACHE_H
+#define TRAIN_SCHEDULE_OPTIMISATION_CLAUSECACHE_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Timetabler.h"
+
+#if MAXSATNID==1
+
+// Clauses over the route section variables (t^<route>^<sequence number>,
+// the train id being its route id), which only depend on the shared
+// infrastructure of instances that differ in some service intentions.
+// They come from the learnt clauses and the cores of a search (cores over
+// the unit soft clauses of the objective give the clause "one of these
+// sections is used"), and are kept in a text file, one clause per line:
+//   c timetabler clause cache 1
+//   t^111^3 -t^111^5
+// A cached clause may not hold for another instance: it is only added to an
+// encoding after a SAT call proves it (see 'inject').
+class ClauseCache {
+public:
+    // At most this many clauses, the shortest ones, are saved.
+    static const int maxClauses = 100000;
+    // Conflicts allowed to prove a cached clause.
+    static const int conflictBudget = 1000;
+
+    // A missing file is an empty cache.
+    bool load(const std::string &file, std::string &error);
+    bool save(const std::string &file, std::string &error) const;
+
+    // Adds to the encoding of 'request' the cached clauses it implies, as
+    // hard clauses, and returns their number. Call before the encoding is
+    // loaded into 'request.S'.
+    int inject(Timetabler &request);
+
+    // Called by 'request' after every SAT call of its algorithm on 'solver',
+    // when the clauses it learns follow from the encoding: keeps its core and
+    // its learnt clauses over route section variables.
+    void collect(Timetabler &request, Solver *solver);
+
+    int size() const { return clauses.size(); }
+
+private:
+    static bool shared(const std::string &name);
+    // Literal of a cached clause, empty if it cannot be named.
+    std::string name(Timetabler &request, Lit p);
+    void add(Timetabler &request, const vec<Lit> &clause);
+
+    std::set<std::vector<std::string>> clauses;// sorted literals
+    // Assumption variable of a unit soft clause -> negation of that clause.
+    std::map<int, Lit> softs;
+    int mappedSofts = 0;
+    double lastExport = -1;
+};
+
+#endif
+
+#endif //TRAIN_SCHEDULE_OPTIMISATION_CLAUSECACHE_H
@@ -0,0 +1,313 @@
+/*!
+ * Timetabler Copyright (c) 2019 Alexandre Lemos, Pedro T Monteiro, Ines Lynce
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef MAXSATNID
+#define MAXSATNID 1
+#endif
+
+#include "FormulaCache.h"
+
+#if MAXSATNID<5
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+#include <vector>
+
+using namespace openwbo;
+
+namespace {
+
+// Arrays of the image, in file order.
+enum Section {
+    Label, NameStart, Names,
+    HardStart, HardLits,
+    CardStart, CardLits, CardRhs,
+    PBStart, PBLits, PBCoeffs, PBRhs, PBSign,
+    ObjLits, ObjCoeffs,
+    Sections
+};
+const size_t elementSize[Sections] = {1, 4, 1, 4, 4, 4, 4, 8, 4, 4, 8, 8, 1, 4, 8};
+
+const char magic[8] = {'T', 'T', 'F', 'O', 'R', 'M', 0, 0};
+const uint32_t endian = 0x01020304;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian;
+    uint64_t key;
+    uint64_t size;// of the file
+    uint64_t vars;
+    uint64_t objective;// 1 with an objective
+    int64_t objConst;
+    uint64_t offset[Sections];// in bytes
+    uint64_t count[Sections];// of elements
+};
+
+template<class T>
+void put(std::vector<char> &section, T value) {
+    const char *bytes = (const char *) &value;
+    section.insert(section.end(), bytes, bytes + sizeof(T));
+}
+
+void putLits(std::vector<char> &start, std::vector<char> &lits, const vec<Lit> &clause) {
+    for (int i = 0; i < clause.size(); i++)
+        put<uint32_t>(lits, toInt(clause[i]));
+    put<uint32_t>(start, lits.size() / 4);
+}
+
+// FNV-1a
+void hashBytes(uint64_t &hash, const char *bytes, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        hash ^= (unsigned char) bytes[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+}
+
+const uint32_t FormulaCache::version;
+
+bool FormulaCache::key(const char *input, const std::string &options, uint64_t &key, std::string &error) {
+    std::ifstream in(input, std::ios::binary);
+    if (!in.is_open()) {
+        error = std::string("Cannot read ") + input;
+        return false;
+    }
+    key = 14695981039346656037ULL;
+    hashBytes(key, (const char *) &version, sizeof(version));
+    hashBytes(key, options.c_str(), options.size() + 1);
+    char buffer[1 << 16];
+    while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0)
+        hashBytes(key, buffer, in.gcount());
+    return true;
+}
+
+bool FormulaCache::save(const std::string &file, uint64_t key, const std::string &label,
+                        MaxSATFormula *formula, std::string &error) {
+    std::vector<char> section[Sections];
+    section[Label].assign(label.begin(), label.end());
+    put<uint32_t>(section[NameStart], 0);
+    for (int i = 0; i < formula->nVars(); i++) {
+        indexMap::const_iterator it = formula->getIndexToName().find(i);
+        if (it != formula->getIndexToName().end())
+            section[Names].insert(section[Names].end(), it->second.begin(), it->second.end());
+        put<uint32_t>(section[NameStart], section[Names].size());
+    }
+    put<uint32_t>(section[HardStart], 0);
+    for (int i = 0; i < formula->nHard(); i++)
+        putLits(section[HardStart], section[HardLits], formula->getHardClause(i).clause);
+    put<uint32_t>(section[CardStart], 0);
+    for (int i = 0; i < formula->nCard(); i++) {
+        Card *card = formula->getCardinalityConstraint(i);
+        putLits(section[CardStart], section[CardLits], card->_lits);
+        put<int64_t>(section[CardRhs], card->_rhs);
+    }
+    put<uint32_t>(section[PBStart], 0);
+    for (int i = 0; i < formula->nPB(); i++) {
+        PB *p = formula->getPBConstraint(i);
+        putLits(section[PBStart], section[PBLits], p->_lits);
+        for (int j = 0; j < p->_coeffs.size(); j++)
+            put<uint64_t>(section[PBCoeffs], p->_coeffs[j]);
+        put<int64_t>(section[PBRhs], p->_rhs);
+        put<uint8_t>(section[PBSign], p->_sign);
+    }
+    Header header;
+    memset(&header, 0, sizeof(header));
+    PBObjFunction *of = formula->getObjFunction();
+    if (of != NULL) {
+        header.objective = 1;
+        header.objConst = of->_const;
+        for (int i = 0; i < of->_lits.size(); i++) {
+            put<uint32_t>(section[ObjLits], toInt(of->_lits[i]));
+            put<uint64_t>(section[ObjCoeffs], of->_coeffs[i]);
+        }
+    }
+
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.endian = endian;
+    header.key = key;
+    header.vars = formula->nVars();
+    uint64_t offset = sizeof(Header);
+    for (int s = 0; s < Sections; s++) {
+        offset = (offset + 7) & ~(uint64_t) 7;
+        header.offset[s] = offset;
+        header.count[s] = section[s].size() / elementSize[s];
+        offset += section[s].size();
+    }
+    header.size = offset;
+
+    std::string tmp = file + ".tmp";
+    FILE *out = fopen(tmp.c_str(), "wb");
+    if (out == NULL) {
+        error = "Cannot write " + tmp;
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    for (int s = 0; s < Sections && ok; s++) {
+        static const char padding[8] = {0};
+        long position = ftell(out);
+        ok = fwrite(padding, 1, header.offset[s] - position, out) == header.offset[s] - position &&
+             fwrite(section[s].data(), 1, section[s].size(), out) == section[s].size();
+    }
+    ok = fflush(out) == 0 && !ferror(out) && ok;
+    ok = fclose(out) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), file.c_str()) != 0) {
+        error = "Cannot write " + file;
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Checks the arrays of 'header' against a file of 'size' bytes.
+static bool valid(const Header &header, uint64_t size, const char *image) {
+    if (header.size != size)
+        return false;
+    for (int s = 0; s < Sections; s++)
+        if (header.offset[s] % 8 != 0 || header.offset[s] > size ||
+            header.count[s] > (size - header.offset[s]) / elementSize[s])
+            return false;
+    // Every constraint spans its literals, in order.
+    const Section starts[] = {NameStart, HardStart, CardStart, PBStart};
+    const Section lits[] = {Names, HardLits, CardLits, PBLits};
+    for (int k = 0; k < 4; k++) {
+        const uint32_t *start = (const uint32_t *) (image + header.offset[starts[k]]);
+        if (header.count[starts[k]] == 0 || start[0] != 0 ||
+            start[header.count[starts[k]] - 1] != header.count[lits[k]])
+            return false;
+        for (uint64_t i = 1; i < header.count[starts[k]]; i++)
+            if (start[i] < start[i - 1])
+                return false;
+    }
+    if (header.count[NameStart] != header.vars + 1 ||
+        header.count[CardRhs] + 1 != header.count[CardStart] ||
+        header.count[PBRhs] + 1 != header.count[PBStart] || header.count[PBSign] + 1 != header.count[PBStart] ||
+        header.count[PBCoeffs] != header.count[PBLits] || header.count[ObjCoeffs] != header.count[ObjLits])
+        return false;
+    const Section literals[] = {HardLits, CardLits, PBLits, ObjLits};
+    for (Section s: literals) {
+        const uint32_t *lit = (const uint32_t *) (image + header.offset[s]);
+        for (uint64_t i = 0; i < header.count[s]; i++)
+            if (lit[i] / 2 >= header.vars)
+                return false;
+    }
+    return true;
+}
+
+MaxSATFormula *FormulaCache::load(const std::string &file, uint64_t key, std::string &label,
+                                  std::string &error) {
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "no compiled encoding in " + file;
+        return NULL;
+    }
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t) st.st_size >= sizeof(Header))
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        error = "Cannot read " + file;
+        return NULL;
+    }
+    const char *image = (const char *) map;
+    const Header &header = *(const Header *) image;
+    if (memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version ||
+        header.endian != endian || !valid(header, st.st_size, image)) {
+        munmap(map, st.st_size);
+        error = "Invalid compiled encoding " + file;
+        return NULL;
+    }
+    if (header.key != key) {
+        munmap(map, st.st_size);
+        error = file + " holds another instance or encoding options";
+        return NULL;
+    }
+
+#define ARRAY(type, s) ((const type *) (image + header.offset[s]))
+    label.assign(ARRAY(char, Label), header.count[Label]);
+    MaxSATFormula *formula = new MaxSATFormula();
+    formula->setFormat(_FORMAT_PB_);
+    const uint32_t *nameStart = ARRAY(uint32_t, NameStart);
+    for (uint64_t i = 0; i < header.vars; i++) {
+        if (nameStart[i] == nameStart[i + 1]) {
+            formula->newVar();
+            continue;
+        }
+        std::vector<char> name(ARRAY(char, Names) + nameStart[i], ARRAY(char, Names) + nameStart[i + 1]);
+        name.push_back('\0');
+        formula->newVarName(&name[0]);
+    }
+    vec<Lit> lits;
+    vec<uint64_t> coeffs;
+    const uint32_t *start = ARRAY(uint32_t, HardStart);
+    for (uint64_t i = 0; i + 1 < header.count[HardStart]; i++) {
+        lits.clear();
+        for (uint32_t j = start[i]; j < start[i + 1]; j++)
+            lits.push(NSPACE::toLit(ARRAY(uint32_t, HardLits)[j]));
+        formula->addHardClause(lits);
+    }
+    // As in Timetabler::copyEncoding
+    start = ARRAY(uint32_t, CardStart);
+    for (uint64_t i = 0; i + 1 < header.count[CardStart]; i++) {
+        lits.clear();
+        for (uint32_t j = start[i]; j < start[i + 1]; j++)
+            lits.push(NSPACE::toLit(ARRAY(uint32_t, CardLits)[j]));
+        coeffs.clear();
+        coeffs.growTo(lits.size(), 1);
+        PB pb(lits, coeffs, ARRAY(int64_t, CardRhs)[i], true);
+        formula->addPBConstraint(&pb);
+    }
+    start = ARRAY(uint32_t, PBStart);
+    for (uint64_t i = 0; i + 1 < header.count[PBStart]; i++) {
+        lits.clear();
+        coeffs.clear();
+        for (uint32_t j = start[i]; j < start[i + 1]; j++) {
+            lits.push(NSPACE::toLit(ARRAY(uint32_t, PBLits)[j]));
+            coeffs.push(ARRAY(uint64_t, PBCoeffs)[j]);
+        }
+        PB pb(lits, coeffs, ARRAY(int64_t, PBRhs)[i], ARRAY(uint8_t, PBSign)[i] != 0);
+        formula->addPBConstraint(&pb);
+    }
+    if (header.objective) {
+        lits.clear();
+        coeffs.clear();
+        for (uint64_t i = 0; i < header.count[ObjLits]; i++) {
+            lits.push(NSPACE::toLit(ARRAY(uint32_t, ObjLits)[i]));
+            coeffs.push(ARRAY(uint64_t, ObjCoeffs)[i]);
+        }
+        PBObjFunction of(lits, coeffs, header.objConst);
+        formula->addObjFunction(&of);
+    }
+#undef ARRAY
+    munmap(map, st.st_size);
+    return formula;
+}
+
+#endif
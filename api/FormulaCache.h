@@ -0,0 +1,43 @@
+//
+// Compiled encodings reused across runs.
+//
+
+#ifndef TRAIN_SCHEDULE_OPTIMISATION_FORMULACACHE_H
+#define TRAIN_SCHEDULE_OPTIMISATION_FORMULACACHE_H
+
+#include <stdint.h>
+#include <string>
+
+#include "Timetabler.h"
+
+#if MAXSATNID<5
+
+// Binary image of an encoded MaxSATFormula: its variable names (the decode
+// tables, e.g. t^<train>^<sequence number> or s^<train>^<t>^<marker>), hard
+// clauses, cardinality and PB constraints and objective. A file holds one
+// encoding, identified by a key (see 'key'), and is mapped into memory to
+// be read: a fixed header gives the offset and length of every array, each
+// 8-byte aligned, and constraint i spans [start[i], start[i + 1]) of the
+// literals of its kind. Literals are stored as toInt(Lit), in the byte
+// order of the writer; a file of another version, byte order or key is
+// ignored.
+class FormulaCache {
+public:
+    static const uint32_t version = 3;
+
+    // Key of the encoding of the file 'input' with the encoding options
+    // 'options' (e.g. "opt-time=2 relax=0"): a hash of both and of the
+    // version. Returns false if 'input' cannot be read.
+    static bool key(const char *input, const std::string &options, uint64_t &key, std::string &error);
+    // 'save' writes a temporary file and renames it over 'file'.
+    static bool save(const std::string &file, uint64_t key, const std::string &label,
+                     openwbo::MaxSATFormula *formula, std::string &error);
+    // Returns the encoding saved under 'key', or NULL (with the reason in
+    // 'error') if 'file' does not hold it.
+    static openwbo::MaxSATFormula *load(const std::string &file, uint64_t key, std::string &label,
+                                        std::string &error);
+};
+
+#endif
+
+#endif //TRAIN_SCHEDULE_OPTIMISATION_FORMULACACHE_H
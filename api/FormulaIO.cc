@@ -0,0 +1,265 @@
+/*!
+ * Timetabler Copyright (c) 2019 Alexandre Lemos, Pedro T Monteiro, Ines Lynce
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef MAXSATNID
+#define MAXSATNID 1
+#endif
+
+#include "FormulaIO.h"
+
+#if MAXSATNID<5
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using namespace openwbo;
+
+namespace {
+
+// Buffered output of one file, written to a temporary file and renamed.
+class Output {
+public:
+    explicit Output(const std::string &file) : file(file), tmp(file + ".tmp"), buffer(1 << 20) {
+        out = fopen(tmp.c_str(), "w");
+        if (out != NULL)
+            setvbuf(out, &buffer[0], _IOFBF, buffer.size());
+    }
+
+    ~Output() {
+        if (out != NULL) {
+            fclose(out);
+            remove(tmp.c_str());
+        }
+    }
+
+    FILE *out;
+
+    bool close(std::string &error) {
+        bool ok = out != NULL && !ferror(out);
+        if (out != NULL)
+            ok = fclose(out) == 0 && ok;
+        out = NULL;
+        if (!ok || rename(tmp.c_str(), file.c_str()) != 0) {
+            error = "Cannot write " + file;
+            remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::string file, tmp;
+    std::vector<char> buffer;
+};
+
+// Writes sum coeffs[i] * lits[i] >= rhs over positive literals.
+void writeLinear(FILE *out, const vec<Lit> &lits, const vec<int64_t> &coeffs, int64_t rhs) {
+    for (int i = 0; i < lits.size(); i++) {
+        int64_t coeff = coeffs[i];
+        if (sign(lits[i])) {
+            rhs -= coeff;
+            coeff = -coeff;
+        }
+        fprintf(out, "%+" PRId64 " x%d ", coeff, var(lits[i]) + 1);
+    }
+    fprintf(out, ">= %" PRId64 " ;\n", rhs);
+}
+
+bool satisfied(const vec<Lit> &lits, const vec<uint64_t> &coeffs, int64_t rhs, bool atMost,
+               const vec<lbool> &model) {
+    int64_t sum = 0;
+    for (int i = 0; i < lits.size(); i++)
+        if (model[var(lits[i])] == (sign(lits[i]) ? l_False : l_True))
+            sum += coeffs.size() > 0 ? coeffs[i] : 1;
+    return atMost ? sum <= rhs : sum >= rhs;
+}
+
+}
+
+bool FormulaIO::writeVarMap(const std::string &file, MaxSATFormula *formula, std::string &error) {
+    Output map(file + ".varmap");
+    if (map.out == NULL) {
+        error = "Cannot write " + file + ".varmap";
+        return false;
+    }
+    for (indexMap::const_iterator it = formula->getIndexToName().begin();
+         it != formula->getIndexToName().end(); it++)
+        fprintf(map.out, "%d %s\n", it->first + 1, it->second.c_str());
+    return map.close(error);
+}
+
+bool FormulaIO::writeWCNF(const std::string &file, MaxSATFormula *formula, std::string &error) {
+    if (formula->nCard() > 0 || formula->nPB() > 0) {
+        error = "The encoding has cardinality or PB constraints, which WCNF cannot hold (use OPB)";
+        return false;
+    }
+    PBObjFunction *of = formula->getObjFunction();
+    int softs = of == NULL ? 0 : of->_lits.size();
+    uint64_t top = 1;
+    for (int i = 0; i < softs; i++) {
+        if (top + of->_coeffs[i] < top) {
+            error = "The weights of the objective overflow WCNF";
+            return false;
+        }
+        top += of->_coeffs[i];
+    }
+    Output wcnf(file);
+    if (wcnf.out == NULL) {
+        error = "Cannot write " + file;
+        return false;
+    }
+    fprintf(wcnf.out, "c timetabler encoding, variables in %s.varmap\n", file.c_str());
+    if (of != NULL && of->_const != 0)
+        fprintf(wcnf.out, "c objective constant %" PRId64 "\n", (int64_t) of->_const);
+    fprintf(wcnf.out, "p wcnf %d %d %" PRIu64 "\n", formula->nVars(), formula->nHard() + softs, top);
+    for (int i = 0; i < formula->nHard(); i++) {
+        const vec<Lit> &clause = formula->getHardClause(i).clause;
+        fprintf(wcnf.out, "%" PRIu64, top);
+        for (int j = 0; j < clause.size(); j++)
+            fprintf(wcnf.out, " %d", sign(clause[j]) ? -(var(clause[j]) + 1) : var(clause[j]) + 1);
+        fprintf(wcnf.out, " 0\n");
+    }
+    for (int i = 0; i < softs; i++) {
+        Lit l = of->_lits[i];
+        fprintf(wcnf.out, "%" PRIu64 " %d 0\n", of->_coeffs[i], sign(l) ? var(l) + 1 : -(var(l) + 1));
+    }
+    return wcnf.close(error) && writeVarMap(file, formula, error);
+}
+
+bool FormulaIO::writeOPB(const std::string &file, MaxSATFormula *formula, std::string &error) {
+    Output opb(file);
+    if (opb.out == NULL) {
+        error = "Cannot write " + file;
+        return false;
+    }
+    fprintf(opb.out, "* #variable= %d #constraint= %d\n", formula->nVars(),
+            formula->nHard() + formula->nCard() + formula->nPB());
+    fprintf(opb.out, "* timetabler encoding, variables in %s.varmap\n", file.c_str());
+    PBObjFunction *of = formula->getObjFunction();
+    if (of != NULL && of->_lits.size() > 0) {
+        int64_t constant = of->_const;
+        fprintf(opb.out, "min:");
+        for (int i = 0; i < of->_lits.size(); i++) {
+            int64_t coeff = of->_coeffs[i];
+            if (sign(of->_lits[i])) {
+                constant += coeff;
+                coeff = -coeff;
+            }
+            fprintf(opb.out, " %+" PRId64 " x%d", coeff, var(of->_lits[i]) + 1);
+        }
+        fprintf(opb.out, " ;\n");
+        if (constant != 0)
+            fprintf(opb.out, "* objective constant %" PRId64 "\n", constant);
+    }
+    vec<int64_t> coeffs;
+    for (int i = 0; i < formula->nHard(); i++) {
+        const vec<Lit> &clause = formula->getHardClause(i).clause;
+        coeffs.clear();
+        coeffs.growTo(clause.size(), 1);
+        writeLinear(opb.out, clause, coeffs, 1);
+    }
+    // Cardinality and PB constraints of the formula are sums <= rhs: their
+    // negations are sums >= -rhs.
+    for (int i = 0; i < formula->nCard(); i++) {
+        Card *card = formula->getCardinalityConstraint(i);
+        coeffs.clear();
+        coeffs.growTo(card->_lits.size(), -1);
+        writeLinear(opb.out, card->_lits, coeffs, -card->_rhs);
+    }
+    for (int i = 0; i < formula->nPB(); i++) {
+        PB *p = formula->getPBConstraint(i);
+        coeffs.clear();
+        for (int j = 0; j < p->_coeffs.size(); j++)
+            coeffs.push(p->_sign ? -(int64_t) p->_coeffs[j] : (int64_t) p->_coeffs[j]);
+        writeLinear(opb.out, p->_lits, coeffs, p->_sign ? -p->_rhs : p->_rhs);
+    }
+    return opb.close(error) && writeVarMap(file, formula, error);
+}
+
+int FormulaIO::readAssignment(const std::string &file, MaxSATFormula *formula, vec<lbool> &model,
+                              std::string &error) {
+    std::ifstream in(file);
+    if (!in.is_open()) {
+        error = "Cannot read " + file;
+        return -1;
+    }
+    model.clear();
+    model.growTo(formula->nVars(), l_False);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, 2, "v ") != 0)
+            continue;
+        std::istringstream values(line.substr(2));
+        std::string token;
+        std::vector<std::string> tokens;
+        while (values >> token)
+            tokens.push_back(token);
+        if (tokens.size() == 1 && (int) tokens[0].size() == formula->nVars() &&
+            tokens[0].find_first_not_of("01") == std::string::npos) {
+            for (int i = 0; i < formula->nVars(); i++)
+                model[i] = tokens[0][i] == '1' ? l_True : l_False;
+            continue;
+        }
+        for (const std::string &t: tokens) {
+            size_t at = 0;
+            bool negative = t[at] == '-' || t[at] == '~';
+            if (negative)
+                at++;
+            if (at < t.size() && t[at] == 'x')
+                at++;
+            char *end;
+            long v = strtol(t.c_str() + at, &end, 10);
+            if (*end != '\0' || end == t.c_str() + at || v < 0 || v > formula->nVars()) {
+                error = "Invalid literal " + t + " in " + file;
+                return -1;
+            }
+            if (v > 0)
+                model[(int) v - 1] = negative ? l_False : l_True;
+        }
+    }
+    return violations(formula, model);
+}
+
+int FormulaIO::violations(MaxSATFormula *formula, const vec<lbool> &model) {
+    int violated = 0;
+    vec<uint64_t> ones;
+    for (int i = 0; i < formula->nHard(); i++)
+        if (!satisfied(formula->getHardClause(i).clause, ones, 1, false, model))
+            violated++;
+    for (int i = 0; i < formula->nCard(); i++) {
+        Card *card = formula->getCardinalityConstraint(i);
+        if (!satisfied(card->_lits, ones, card->_rhs, true, model))
+            violated++;
+    }
+    for (int i = 0; i < formula->nPB(); i++) {
+        PB *p = formula->getPBConstraint(i);
+        if (!satisfied(p->_lits, p->_coeffs, p->_rhs, p->_sign, model))
+            violated++;
+    }
+    return violated;
+}
+
+#endif
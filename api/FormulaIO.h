@@ -0,0 +1,51 @@
+//
+// Encodings exchanged with other MaxSAT and PB solvers.
+//
+
+#ifndef TRAIN_SCHEDULE_OPTIMISATION_FORMULAIO_H
+#define TRAIN_SCHEDULE_OPTIMISATION_FORMULAIO_H
+
+#include <string>
+
+#include "Timetabler.h"
+
+#if MAXSATNID<5
+
+// Writes an encoding in the WCNF format of the MaxSAT Evaluations or in the
+// OPB format of the PB competitions, and reads back the assignment another
+// solver found for it. Variable i of the encoding is variable i + 1 of the
+// files (x<i + 1> in OPB). The constraints are written one at a time from
+// the formula, through a buffered stream, so the file never exists in
+// memory as a whole. Every named variable is listed in a side file
+// <file>.varmap, one per line:
+//   12 s^111^28800^A
+// (the names give the train, the route section or marker and the time, see
+// Timetabler::decodeModel).
+class FormulaIO {
+public:
+    // Hard clauses have weight top (the sum of the objective + 1) and every
+    // objective term w * l becomes the soft clause -l of weight w. Fails if
+    // the encoding has cardinality or PB constraints, which WCNF cannot
+    // hold.
+    static bool writeWCNF(const std::string &file, openwbo::MaxSATFormula *formula, std::string &error);
+    // Constraints over negative literals are rewritten over positive ones
+    // (w * ~x = w - w * x), so the file only uses the linear OPB syntax.
+    static bool writeOPB(const std::string &file, openwbo::MaxSATFormula *formula, std::string &error);
+    // Reads the "v" lines of the output of a solver: literals ("v 1 -2 3",
+    // "v x1 -x2 x3") or, as in the MaxSAT Evaluations since 2022, one digit
+    // per variable ("v 101"). Unlisted variables are false. Returns the
+    // number of hard constraints of 'formula' that 'model' violates, or -1
+    // if 'file' cannot be read.
+    static int readAssignment(const std::string &file, openwbo::MaxSATFormula *formula, vec<lbool> &model,
+                              std::string &error);
+    // Number of hard clauses, cardinality and PB constraints of 'formula'
+    // that 'model' (over at least its variables) violates.
+    static int violations(openwbo::MaxSATFormula *formula, const vec<lbool> &model);
+
+private:
+    static bool writeVarMap(const std::string &file, openwbo::MaxSATFormula *formula, std::string &error);
+};
+
+#endif
+
+#endif //TRAIN_SCHEDULE_OPTIMISATION_FORMULAIO_H
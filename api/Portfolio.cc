@@ -0,0 +1,576 @@
+/*!
+ * Timetabler Copyright (c) 2019 Alexandre Lemos, Pedro T Monteiro, Ines Lynce
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef MAXSATNID
+#define MAXSATNID 1
+#endif
+
+#include "Portfolio.h"
+#include "FormulaIO.h"
+
+#if MAXSATNID<5
+#include <errno.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+
+using namespace openwbo;
+
+// Connects to "unix:<path>" or "<host>:<port>".
+static int connectTo(const std::string &address, std::string &error) {
+    if (address.compare(0, 5, "unix:") == 0) {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::string path = address.substr(5);
+        if (path.size() >= sizeof(addr.sun_path)) {
+            error = "socket path too long: " + path;
+            return -1;
+        }
+        strcpy(addr.sun_path, path.c_str());
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || ::connect(fd, (sockaddr *) &addr, sizeof(addr)) < 0) {
+            error = "cannot connect to " + address + ": " + strerror(errno);
+            if (fd >= 0)
+                close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos) {
+        error = "invalid broker address " + address;
+        return -1;
+    }
+    addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    int rc = getaddrinfo(address.substr(0, colon).c_str(), address.substr(colon + 1).c_str(), &hints, &res);
+    if (rc != 0) {
+        error = "cannot resolve " + address + ": " + gai_strerror(rc);
+        return -1;
+    }
+    int fd = -1;
+    for (addrinfo *a = res; a != NULL && fd < 0; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd >= 0 && ::connect(fd, a->ai_addr, a->ai_addrlen) < 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    if (fd < 0)
+        error = "cannot connect to " + address;
+    return fd;
+}
+
+// Writes all of 'message', false if the peer went away.
+static bool writeAll(int fd, const std::string &message) {
+    size_t done = 0;
+    while (done < message.size()) {
+        ssize_t n = write(fd, message.data() + done, message.size() - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        done += n;
+    }
+    return true;
+}
+
+static std::string modelString(const vec<lbool> &model, int vars) {
+    std::string values(vars, '0');
+    for (int i = 0; i < vars && i < model.size(); i++)
+        if (model[i] == l_True)
+            values[i] = '1';
+    return values;
+}
+
+static const char *statusName(StatusCode status) {
+    if (status == _OPTIMUM_)
+        return "OPTIMUM";
+    if (status == _SATISFIABLE_)
+        return "SATISFIABLE";
+    if (status == _UNSATISFIABLE_)
+        return "UNSATISFIABLE";
+    return "UNKNOWN";
+}
+
+BrokerClient::~BrokerClient() {
+    if (fd < 0)
+        return;
+    shutdown(fd, SHUT_RDWR);
+    if (reader.joinable())
+        reader.join();
+    close(fd);
+}
+
+bool BrokerClient::connect(const std::string &address, uint64_t hash, int vars, std::string &error) {
+    fd = connectTo(address, error);
+    if (fd < 0)
+        return false;
+    // The broker going away must not take the worker with it.
+    signal(SIGPIPE, SIG_IGN);
+    this->vars = vars;
+    char hello[80];
+    snprintf(hello, sizeof(hello), "HELLO %" PRIx64 " %d %d\n", hash, vars, (int) getpid());
+    send(hello);
+
+    // The answer says whether the portfolio is deterministic. Read it byte
+    // by byte, so that the reader thread gets everything after it.
+    std::string answer;
+    char c;
+    ssize_t n;
+    while ((n = recv(fd, &c, 1, 0)) == 1 && c != '\n')
+        answer += c;
+    if (answer.compare(0, 8, "WELCOME ") != 0) {
+        error = n == 1 && answer.compare(0, 6, "ERROR ") == 0 ? "broker: " + answer.substr(6)
+                                                              : "no answer from the broker";
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    syncConflicts = strtoull(answer.c_str() + 8, NULL, 10);
+#if MAXSATNID!=1
+    if (syncConflicts > 0) {
+        error = "a deterministic portfolio needs TT-Open-WBO-Inc workers";
+        close(fd);
+        fd = -1;
+        return false;
+    }
+#endif
+    reader = std::thread([this]() { read(); });
+    return true;
+}
+
+void BrokerClient::send(const std::string &message) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (fd >= 0)
+        writeAll(fd, message);
+}
+
+void BrokerClient::sendBound(uint64_t cost, const vec<lbool> &model) {
+    if (model.size() < vars)
+        return;
+    send("BOUND " + std::to_string(cost) + " " + modelString(model, vars) + "\n");
+}
+
+void BrokerClient::sendLowerBound(uint64_t lb) {
+    send("LB " + std::to_string(lb) + "\n");
+}
+
+void BrokerClient::sendDone(StatusCode status) {
+    send(std::string("DONE ") + statusName(status) + "\n");
+    // The worker is finishing: a STOP must not interrupt it.
+    std::lock_guard<std::mutex> guard(lock);
+    onStop = nullptr;
+}
+
+bool BrokerClient::sync() {
+    std::unique_lock<std::mutex> guard(lock);
+    if (fd < 0 || stopped)
+        return false;
+    writeAll(fd, "SYNC\n");
+    released.wait(guard, [this]() { return go || stopped; });
+    go = false;
+    return !stopped;
+}
+
+bool BrokerClient::poll(uint64_t &cost, vec<lbool> &model) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!received)
+        return false;
+    received = false;
+    cost = receivedCost;
+    model.clear();
+    for (char c: receivedModel)
+        model.push(c == '1' ? l_True : l_False);
+    return true;
+}
+
+void BrokerClient::read() {
+    FILE *in = fdopen(dup(fd), "r");
+    if (in == NULL)
+        return;
+    char *line = NULL;
+    size_t n = 0;
+    ssize_t length;
+    while ((length = getline(&line, &n, in)) > 0) {
+        if (line[length - 1] == '\n')
+            line[--length] = '\0';
+        if (strncmp(line, "BOUND ", 6) == 0) {
+            char *values = strchr(line + 6, ' ');
+            if (values == NULL || strlen(values + 1) != (size_t) vars)
+                continue;
+            std::lock_guard<std::mutex> guard(lock);
+            receivedCost = strtoull(line + 6, NULL, 10);
+            receivedModel.assign(values + 1);
+            received = true;
+        } else if (strcmp(line, "GO") == 0) {
+            std::lock_guard<std::mutex> guard(lock);
+            go = true;
+            released.notify_all();
+        } else if (strcmp(line, "STOP") == 0) {
+            std::function<void()> stop;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopped = true;
+                released.notify_all();
+                stop = onStop;
+            }
+            if (stop)
+                stop();
+        } else if (strncmp(line, "ERROR ", 6) == 0) {
+            fprintf(stderr, "c broker: %s\n", line + 6);
+        }
+    }
+    free(line);
+    fclose(in);
+    // Without a broker, the worker goes on alone.
+    std::lock_guard<std::mutex> guard(lock);
+    stopped = true;
+    released.notify_all();
+}
+
+#endif
+
+#if MAXSATNID==1
+
+void Portfolio::send(Worker &worker, const std::string &message) {
+    if (worker.fd >= 0 && !writeAll(worker.fd, message)) {
+        close(worker.fd);
+        worker.fd = -1;
+    }
+}
+
+// Returns false if the worker must be disconnected.
+bool Portfolio::handle(Worker &worker, const std::string &line, std::vector<Worker> &workers) {
+    const char *text = line.c_str();
+    if (strncmp(text, "HELLO ", 6) == 0) {
+        uint64_t h = 0;
+        int vars = 0, pid = 0;
+        if (sscanf(text + 6, "%" SCNx64 " %d %d", &h, &vars, &pid) < 2 || h != hash ||
+            vars != request.maxsat_formula->nVars()) {
+            send(worker, "ERROR another encoding (instance or -opt-time)\nSTOP\n");
+            return false;
+        }
+        worker.hello = true;
+        worker.pid = pid;
+        send(worker, "WELCOME " + std::to_string(syncConflicts) + "\n");
+        // A deterministic portfolio only exchanges models at synchronisation
+        // points.
+        if (model.size() > 0 && syncConflicts == 0)
+            send(worker, "BOUND " + std::to_string(cost) + " " + modelString(model, model.size()) + "\n");
+        return true;
+    }
+    if (!worker.hello)
+        return false;
+
+    if (strncmp(text, "BOUND ", 6) == 0) {
+        const char *values = strchr(text + 6, ' ');
+        if (values == NULL || strlen(values + 1) != (size_t) request.maxsat_formula->nVars())
+            return true;
+        vec<lbool> incumbent;
+        for (const char *c = values + 1; *c != '\0'; c++)
+            incumbent.push(*c == '1' ? l_True : l_False);
+        if (FormulaIO::violations(request.maxsat_formula, incumbent) > 0) {
+            printf("c portfolio: rejected a model that violates the hard constraints\n");
+            return true;
+        }
+        // Backends may report costs differently: use the objective.
+        uint64_t c = request.planCost(incumbent);
+        if (lb > c) {
+            printf("c portfolio: dropped a lower bound above the cost of a model\n");
+            lb = 0;
+        }
+        if (syncConflicts > 0) {
+            // Ties go to the smallest model, whatever the order of the workers.
+            if (c > cost || (c == cost && strcmp(values + 1, modelString(model, model.size()).c_str()) >= 0))
+                return true;
+        } else if (c >= cost)
+            return true;
+        if (c < cost) {
+            printf("o %" PRIu64 "\n", c);
+            fflush(stdout);
+        }
+        cost = c;
+        incumbent.copyTo(model);
+        improved = true;
+        if (syncConflicts == 0) {
+            std::string message = "BOUND " + std::to_string(cost) + " " + std::string(values + 1) + "\n";
+            for (Worker &other: workers)
+                if (&other != &worker && other.hello)
+                    send(other, message);
+        }
+        if (lb >= cost)
+            status = _OPTIMUM_;
+    } else if (strncmp(text, "LB ", 3) == 0) {
+        uint64_t bound = strtoull(text + 3, NULL, 10);
+        if (model.size() > 0 && bound > cost) {
+            printf("c portfolio: dropped a lower bound above the cost of a model\n");
+            return true;
+        }
+        lb = std::max(lb, bound);
+        if (model.size() > 0 && lb >= cost)
+            status = _OPTIMUM_;
+    } else if (strncmp(text, "DONE ", 5) == 0) {
+        worker.done = true;
+        finished.push_back(worker.pid);
+        // The final model of the worker was sent before.
+        if (strcmp(text + 5, "OPTIMUM") == 0 && model.size() > 0)
+            status = _OPTIMUM_;
+        else if (strcmp(text + 5, "UNSATISFIABLE") == 0 && model.size() == 0)
+            status = _UNSATISFIABLE_;
+    }
+    return true;
+}
+
+bool Portfolio::synchronise(std::vector<Worker> &workers, const std::vector<pid_t> &children) {
+    // Local workers that did not connect yet take part too.
+    for (pid_t pid: children)
+        if (pid > 0 && std::none_of(workers.begin(), workers.end(),
+                                    [pid](const Worker &w) { return w.hello && w.pid == pid; }))
+            return false;
+    bool any = false;
+    for (Worker &w: workers) {
+        if (w.done || w.fd < 0)
+            continue;
+        if (std::none_of(w.pending.begin(), w.pending.end(), [](const std::string &line) {
+                return line == "SYNC" || line.compare(0, 5, "DONE ") == 0;
+            }))
+            return false;
+        any = true;
+    }
+    if (!any && std::all_of(workers.begin(), workers.end(), [](const Worker &w) { return w.pending.empty(); }))
+        return false;
+
+    improved = false;
+    std::vector<Worker *> synced;
+    for (Worker &w: workers)
+        while (!w.pending.empty()) {
+            std::string line = w.pending.front();
+            w.pending.pop_front();
+            if (line == "SYNC") {
+                synced.push_back(&w);
+                break;
+            }
+            handle(w, line, workers);
+            if (w.done)
+                break;
+        }
+    if (status != _UNKNOWN_)
+        return false;
+    for (Worker *w: synced) {
+        if (improved)
+            send(*w, "BOUND " + std::to_string(cost) + " " + modelString(model, model.size()) + "\n");
+        send(*w, "GO\n");
+    }
+    return true;
+}
+
+static int listenOn(sockaddr *addr, socklen_t length) {
+    int fd = socket(addr->sa_family, SOCK_STREAM, 0);
+    int yes = 1;
+    if (fd >= 0)
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    if (fd < 0 || bind(fd, addr, length) < 0 || listen(fd, 64) < 0) {
+        perror("c Error: portfolio");
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+StatusCode Portfolio::run(const std::vector<std::string> &commands) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    hash = request.encodingHash();
+    cost = UINT64_MAX;
+    lb = 0;
+    status = _UNKNOWN_;
+    signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_in remote;
+    memset(&remote, 0, sizeof(remote));
+    remote.sin_family = AF_INET;
+    remote.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    remote.sin_port = htons(port);
+    if (!address.empty() && inet_pton(AF_INET, address.c_str(), &remote.sin_addr) != 1) {
+        printf("c Error: portfolio: invalid address %s\n", address.c_str());
+        return _ERROR_;
+    }
+
+    std::vector<int> listeners;
+    std::string path = "/tmp/timetabler-portfolio-" + std::to_string(getpid()) + ".sock";
+    sockaddr_un local;
+    memset(&local, 0, sizeof(local));
+    local.sun_family = AF_UNIX;
+    strncpy(local.sun_path, path.c_str(), sizeof(local.sun_path) - 1);
+    unlink(path.c_str());
+    listeners.push_back(listenOn((sockaddr *) &local, sizeof(local)));
+    if (port > 0) {
+        listeners.push_back(listenOn((sockaddr *) &remote, sizeof(remote)));
+        char host[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &remote.sin_addr, host, sizeof(host));
+        printf("c portfolio: remote workers join with -broker=<host>:%d (listening on %s)\n", port, host);
+    }
+    for (int fd: listeners)
+        if (fd < 0)
+            return _ERROR_;
+
+    std::vector<pid_t> children;
+    for (size_t i = 0; i < commands.size(); i++) {
+        std::string log = "data/" + request.instance.label + ".worker" + std::to_string(i) + ".log";
+        std::string command = "exec " + commands[i];
+        if (syncConflicts > 0)
+            command += " -seed=" + std::to_string(i + 1);
+        command += " -broker=unix:" + path + " '" + instanceFile + "'";
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            int out = open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (out >= 0)
+                dup2(out, STDOUT_FILENO);
+            execl("/bin/sh", "sh", "-c", command.c_str(), (char *) NULL);
+            _exit(127);
+        }
+        if (pid < 0) {
+            perror("c Error: portfolio");
+            continue;
+        }
+        printf("c portfolio: worker %d (pid %d): %s\n", (int) i, (int) pid, commands[i].c_str());
+        children.push_back(pid);
+    }
+    fflush(stdout);
+
+    std::vector<Worker> workers;
+    bool joined = false;
+    while (status == _UNKNOWN_) {
+        std::vector<pollfd> fds;
+        for (int fd: listeners)
+            fds.push_back({fd, POLLIN, 0});
+        for (Worker &w: workers)
+            fds.push_back({w.fd, POLLIN, 0});
+        if (::poll(&fds[0], fds.size(), 100) < 0 && errno != EINTR)
+            break;
+
+        for (size_t i = 0; i < listeners.size(); i++)
+            if (fds[i].revents & POLLIN) {
+                int fd = accept(listeners[i], NULL, NULL);
+                if (fd >= 0) {
+                    workers.push_back({fd, "", false, false, 0, {}});
+                    joined = true;
+                }
+            }
+        for (size_t i = listeners.size(); i < fds.size(); i++) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            Worker &w = workers[i - listeners.size()];
+            char buffer[65536];
+            ssize_t n = ::read(w.fd, buffer, sizeof(buffer));
+            if (n <= 0) {
+                close(w.fd);
+                w.fd = -1;
+                continue;
+            }
+            w.buffer.append(buffer, n);
+            size_t end;
+            while (w.fd >= 0 && (end = w.buffer.find('\n')) != std::string::npos) {
+                std::string line = w.buffer.substr(0, end);
+                w.buffer.erase(0, end + 1);
+                if (syncConflicts > 0 && w.hello)
+                    w.pending.push_back(line);
+                else if (!handle(w, line, workers)) {
+                    close(w.fd);
+                    w.fd = -1;
+                }
+            }
+        }
+        for (size_t i = 0; i < children.size(); i++)
+            if (children[i] > 0 && waitpid(children[i], NULL, WNOHANG) == children[i])
+                children[i] = 0;
+        while (syncConflicts > 0 && status == _UNKNOWN_ && synchronise(workers, children))
+            ;
+        size_t j = 0;
+        for (size_t i = 0; i < workers.size(); i++)
+            if (workers[i].fd >= 0 || !workers[i].pending.empty())
+                workers[j++] = workers[i];
+        workers.resize(j);
+
+        bool running = std::count(children.begin(), children.end(), 0) < (long) children.size();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (timeLimit > 0 && elapsed.count() >= timeLimit)
+            break;
+        // Only remote workers: wait for the first one.
+        if (!running && workers.empty() && (joined || !commands.empty()))
+            break;
+    }
+
+    for (Worker &w: workers) {
+        if (!w.done)
+            send(w, "STOP\n");
+        if (w.fd >= 0)
+            close(w.fd);
+    }
+    // Workers that sent DONE are exiting on their own.
+    for (pid_t pid: children)
+        if (pid > 0 && std::find(finished.begin(), finished.end(), pid) == finished.end())
+            kill(pid, SIGTERM);
+    // Workers get a few seconds to write their answer.
+    std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+    for (pid_t pid: children)
+        if (pid > 0) {
+            pid_t done;
+            while ((done = waitpid(pid, NULL, WNOHANG)) == 0 &&
+                   std::chrono::steady_clock::now() - stop < std::chrono::seconds(5))
+                usleep(10000);
+            if (done == 0) {
+                kill(pid, SIGKILL);
+                waitpid(pid, NULL, 0);
+            }
+        }
+    for (int fd: listeners)
+        close(fd);
+    unlink(path.c_str());
+
+    if (status == _UNKNOWN_ && model.size() > 0)
+        status = _SATISFIABLE_;
+    return status;
+}
+
+#endif
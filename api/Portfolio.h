@@ -0,0 +1,166 @@
+//
+// Portfolio of timetabler processes sharing their incumbents.
+//
+
+#ifndef TRAIN_SCHEDULE_OPTIMISATION_PORTFOLIO_H
+#define TRAIN_SCHEDULE_OPTIMISATION_PORTFOLIO_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Timetabler.h"
+
+#if MAXSATNID<5
+
+#if MAXSATNID==2
+using openwbo::StatusCode;// only Loandra declares it in the namespace
+#endif
+
+// Workers talk to the broker of the portfolio over a Unix domain socket
+// ("unix:<path>") or TCP ("<host>:<port>"), with one line per message.
+// Models are strings of 0/1, one per variable of the encoding, which is the
+// same for every backend given the same instance and -opt-time.
+//   worker -> broker:  HELLO <hash> <vars> <pid>   encoding of the worker
+//                      BOUND <cost> <model>    new incumbent
+//                      LB <cost>               proven lower bound
+//                      SYNC                    synchronisation point
+//                      DONE <status>           OPTIMUM, SATISFIABLE,
+//                                              UNSATISFIABLE or UNKNOWN
+//   broker -> worker:  WELCOME <conflicts>     answer to HELLO, see below
+//                      BOUND <cost> <model>    best incumbent of the others
+//                      GO                      leave the synchronisation point
+//                      STOP                    the portfolio is done
+//                      ERROR <message>
+//
+// A deterministic portfolio (WELCOME with a number of conflicts other than
+// 0) exchanges incumbents at fixed points of the search instead of as soon
+// as they are found: a worker sends SYNC after the SAT call that takes its
+// conflicts past the next multiple of that number, and waits for GO. Once
+// every worker is at a synchronisation point or done, the broker takes the
+// messages sent before it, sends the best incumbent (the smallest model
+// among those of least cost) to the workers, then GO. What a worker sees of
+// the others then only depends on the conflicts of every one, so a run
+// without a time limit gives the same plan on any machine.
+class BrokerClient {
+public:
+    BrokerClient() : fd(-1), vars(0), syncConflicts(0), received(false), receivedCost(UINT64_MAX),
+                     go(false), stopped(false) {}
+    ~BrokerClient();
+
+    // 'hash' and 'vars' identify the encoding (Timetabler::encodingHash).
+    bool connect(const std::string &address, uint64_t hash, int vars, std::string &error);
+    bool connected() const { return fd >= 0; }
+    // Conflicts between two synchronisation points, 0 when the portfolio is
+    // not deterministic.
+    uint64_t syncInterval() const { return syncConflicts; }
+
+    // 'model' covers at least the variables of the encoding.
+    void sendBound(uint64_t cost, const vec<lbool> &model);
+    void sendLowerBound(uint64_t lb);
+    void sendDone(StatusCode status);
+    // Sends SYNC and waits for the broker to let the worker go. Returns
+    // false if the portfolio stopped or the broker went away.
+    bool sync();
+
+    // Returns the last incumbent received from the broker, if any arrived
+    // since the last call.
+    bool poll(uint64_t &cost, vec<lbool> &model);
+
+    // Called by the thread reading the broker when the portfolio is done,
+    // unless the worker sent DONE.
+    std::function<void()> onStop;
+
+private:
+    void send(const std::string &message);
+    void read();
+
+    int fd;
+    int vars;
+    uint64_t syncConflicts;
+    std::thread reader;
+    std::mutex lock;// 'fd' writes, the received incumbent and 'go'
+    bool received;
+    uint64_t receivedCost;
+    std::string receivedModel;
+    std::condition_variable released;
+    bool go;
+    bool stopped;
+};
+
+#endif
+
+#if MAXSATNID==1
+
+// Runs the worker command lines of a portfolio, e.g.
+//   ./timetabler -algorithm=4
+//   ./timetabler-loandra
+// as local processes on the instance of 'request', each given a
+// -broker=unix:... option, and brokers their incumbents: every improvement
+// is sent to the other workers. Remote workers join with -broker=<host>:<port>
+// when 'port' is not 0. The portfolio stops when a worker proves optimality
+// or infeasibility, when a proven lower bound meets the best incumbent, at
+// the time limit, or when every worker is done.
+//
+// With 'syncConflicts' other than 0 the portfolio is deterministic (see
+// BrokerClient): local worker i also gets -seed=<i+1>, and there are no
+// remote workers. Every worker must then be a TT-Open-WBO-Inc timetabler.
+//
+// The TCP listener binds 'address', the loopback interface unless one is
+// given: there is no authentication. Models are only accepted if they satisfy
+// the hard constraints, and lower bounds above the cost of such a model are
+// dropped, but a worker that claims a lower bound or optimality is trusted.
+class Portfolio {
+public:
+    Portfolio(Timetabler &request, const std::string &instanceFile, double timeLimit, int port,
+              uint64_t syncConflicts = 0, const std::string &address = "")
+            : request(request), instanceFile(instanceFile), timeLimit(timeLimit), port(port),
+              address(address), syncConflicts(syncConflicts) {}
+
+    // 'commands' holds one worker command line per entry. Returns the status
+    // of the portfolio; the best model is decoded into 'request'.
+    StatusCode run(const std::vector<std::string> &commands);
+
+    uint64_t cost;// of the best model
+    vec<lbool> model;
+
+private:
+    struct Worker {
+        int fd;
+        std::string buffer;
+        bool hello;
+        bool done;
+        pid_t pid;
+        // Deterministic portfolio: messages not taken by a synchronisation
+        // point yet.
+        std::deque<std::string> pending;
+    };
+
+    bool handle(Worker &worker, const std::string &line, std::vector<Worker> &workers);
+    // Takes the messages of every worker up to its next synchronisation
+    // point, if all of them got there, and lets them go.
+    bool synchronise(std::vector<Worker> &workers, const std::vector<pid_t> &children);
+    static void send(Worker &worker, const std::string &message);
+
+    Timetabler &request;
+    std::string instanceFile;
+    double timeLimit;
+    int port;
+    std::string address;// of the TCP listener, loopback when empty
+    uint64_t syncConflicts;
+    uint64_t hash;
+    uint64_t lb;
+    bool improved;// the best model changed since the last synchronisation point
+    std::vector<pid_t> finished;// of the workers that sent DONE
+    StatusCode status;
+};
+
+#endif
+
+#endif //TRAIN_SCHEDULE_OPTIMISATION_PORTFOLIO_H
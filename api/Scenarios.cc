@@ -0,0 +1,229 @@
+/*!
+ * Timetabler Copyright (c) 2019 Alexandre Lemos, Pedro T Monteiro, Ines Lynce
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef MAXSATNID
+#define MAXSATNID 1
+#endif
+
+#include "Scenarios.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
+
+#include "../rapidjson/istreamwrapper.h"
+
+#if MAXSATNID==1
+#include <atomic>
+#include <thread>
+#endif
+
+using namespace rapidjson;
+
+// Ids may be given as numbers or strings, as in the instances.
+static std::string idOf(const Value &v) {
+    if (v.IsInt())
+        return std::to_string(v.GetInt());
+    return v.GetString();
+}
+
+bool readScenarios(const char *file, std::vector<Scenario> &scenarios, std::string &error) {
+    std::ifstream ifs(file);
+    if (!ifs.is_open()) {
+        error = std::string("could not read ") + file;
+        return false;
+    }
+    IStreamWrapper isw(ifs);
+    Document d;
+    try {
+        d.ParseStream(isw);
+        if (d.HasParseError() || !d.IsArray()) {
+            error = "a scenario file is a JSON array";
+            return false;
+        }
+        for (SizeType i = 0; i < d.Size(); i++) {
+            const Value &s = d[i];
+            Scenario scenario;
+            scenario.name = s.HasMember("name") ? idOf(s["name"]) : std::to_string(i);
+            if (s.HasMember("closed_resources"))
+                for (SizeType j = 0; j < s["closed_resources"].Size(); j++)
+                    scenario.closedResources.push_back(idOf(s["closed_resources"][j]));
+            if (s.HasMember("cancelled_trains"))
+                for (SizeType j = 0; j < s["cancelled_trains"].Size(); j++)
+                    scenario.cancelledTrains.push_back(idOf(s["cancelled_trains"][j]));
+            if (s.HasMember("dropped_requirements"))
+                for (SizeType j = 0; j < s["dropped_requirements"].Size(); j++)
+                    scenario.droppedRequirements.push_back(std::make_pair(
+                            idOf(s["dropped_requirements"][j]["service_intention"]),
+                            idOf(s["dropped_requirements"][j]["sequence_number"])));
+            scenarios.push_back(scenario);
+        }
+    } catch (std::runtime_error &e) {
+        error = e.what();
+        return false;
+    }
+    return true;
+}
+
+#if MAXSATNID==1
+
+using namespace openwbo;
+
+bool ScenarioSolver::assumptions(const Scenario &scenario, vec<Lit> &lits, std::string &error) {
+    std::map<std::string, bool> active;
+    indexMap::const_iterator it = request.maxsat_formula->getIndexToName().begin();
+    while (it != request.maxsat_formula->getIndexToName().end()) {
+        if (it->second.compare(0, 2, "a^") == 0)
+            active[it->second] = true;
+        it++;
+    }
+    std::vector<std::string> off;
+    for (const std::string &id: scenario.closedResources)
+        off.push_back("a^resource^" + id);
+    for (const std::string &id: scenario.cancelledTrains)
+        off.push_back("a^train^" + id);
+    for (const std::pair<std::string, std::string> &r: scenario.droppedRequirements)
+        off.push_back("a^requirement^" + r.first + "^" + r.second);
+    for (const std::string &name: off) {
+        if (active.find(name) == active.end()) {
+            error = "Unknown " + request.describeGroup(name);
+            return false;
+        }
+        active[name] = false;
+    }
+    lits.clear();
+    std::map<std::string, bool>::iterator a = active.begin();
+    while (a != active.end()) {
+        if (request.relax && a->second && a->first.compare(0, 11, "a^resource^") != 0) {
+            a++;
+            continue;
+        }
+        std::vector<char> name(a->first.begin(), a->first.end());
+        name.push_back('\0');
+        lits.push(mkLit(request.maxsat_formula->varID(&name[0]), !a->second));
+        a++;
+    }
+    return true;
+}
+
+void ScenarioSolver::solve(Solver *solver, const vec<Lit> &lits, ScenarioOutcome &outcome) {
+    vec<Lit> assumps;
+    lits.copyTo(assumps);
+    lbool res = solver->solveLimited(assumps);
+    if (res == l_False) {
+        outcome.status = _UNSATISFIABLE_;
+        vec<Lit> mus;
+        for (int i = 0; i < solver->conflict.size(); i++)
+            mus.push(~solver->conflict[i]);
+        Timetabler::groupMUS(solver, mus, musPropagations);
+        for (int i = 0; i < mus.size(); i++) {
+            indexMap::const_iterator it = request.maxsat_formula->getIndexToName().find(var(mus[i]));
+            if (it != request.maxsat_formula->getIndexToName().end())
+                outcome.conflict.push_back(request.describeGroup(it->second));
+        }
+        return;
+    }
+    if (res != l_True)
+        return;
+
+    MaxSATFormula *formula = request.copyEncoding();
+    // Groups the scenario switches off are not violations.
+    std::set<int> off;
+    for (int i = 0; i < lits.size(); i++)
+        if (sign(lits[i]))
+            off.insert(var(lits[i]));
+    PBObjFunction *of = formula->getObjFunction();
+    if (request.relax && of != NULL) {
+        int j = 0;
+        for (int i = 0; i < of->_lits.size(); i++)
+            if (off.count(var(of->_lits[i])) == 0) {
+                of->_lits[j] = of->_lits[i];
+                of->_coeffs[j++] = of->_coeffs[i];
+            }
+        of->_lits.shrink(of->_lits.size() - j);
+        of->_coeffs.shrink(of->_coeffs.size() - j);
+    }
+    MaxSAT *S = newAlgorithm(formula);
+    if (S == NULL) {
+        delete formula;
+        outcome.status = _ERROR_;
+        outcome.error = "Invalid MaxSAT algorithm";
+        return;
+    }
+    S->setFixedAssumptions(lits);
+    S->setProgressCallback([&](uint64_t cost) { outcome.cost = cost; });
+    S->loadFormula(formula);
+    outcome.status = Timetabler::search(S, timeLimit, outcome.timedOut);
+    for (int i = 0; i < S->model.size(); i++)
+        outcome.model.push_back(S->model[i]);
+    if (request.relax) {
+        std::set<std::string> switchedOff;
+        for (int v: off)
+            switchedOff.insert(request.describeGroup(request.maxsat_formula->getIndexToName().at(v)));
+        for (const std::string &group: request.relaxedGroups(S->model))
+            if (switchedOff.count(group) == 0)
+                outcome.relaxed.push_back(group);
+    }
+    delete S;
+}
+
+void ScenarioSolver::solve(const std::vector<Scenario> &scenarios, std::vector<ScenarioOutcome> &outcomes) {
+    outcomes.clear();
+    outcomes.resize(scenarios.size());
+    std::vector<vec<Lit> *> lits;
+    for (size_t i = 0; i < scenarios.size(); i++) {
+        lits.push_back(new vec<Lit>());
+        if (!assumptions(scenarios[i], *lits[i], outcomes[i].error))
+            outcomes[i].status = _ERROR_;
+    }
+
+    Solver *base = request.buildSATSolver();
+    std::atomic<int> next(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < std::max(threads, 1); t++)
+        workers.push_back(std::thread([&]() {
+            Solver *solver = new Solver(*base);
+            for (int i = next++; i < (int) scenarios.size(); i = next++) {
+                if (outcomes[i].status == _ERROR_)
+                    continue;
+                try {
+                    solve(solver, *lits[i], outcomes[i]);
+                } catch (std::runtime_error &e) {
+                    outcomes[i].status = _ERROR_;
+                    outcomes[i].error = e.what();
+                } catch (NSPACE::OutOfMemoryException &) {
+                    outcomes[i].status = _ERROR_;
+                    outcomes[i].error = "Out of memory";
+                }
+            }
+            delete solver;
+        }));
+    for (std::thread &w: workers)
+        w.join();
+    delete base;
+    for (vec<Lit> *l: lits)
+        delete l;
+}
+
+#endif
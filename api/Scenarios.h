@@ -0,0 +1,87 @@
+//
+// Batch evaluation of what-if scenarios.
+//
+
+#ifndef TRAIN_SCHEDULE_OPTIMISATION_SCENARIOS_H
+#define TRAIN_SCHEDULE_OPTIMISATION_SCENARIOS_H
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Timetabler.h"
+
+// A variant of the instance, obtained by switching off constraint groups.
+struct Scenario {
+    std::string name;
+    std::vector<std::string> closedResources;   // Resource ids
+    std::vector<std::string> cancelledTrains;   // service intention ids
+    // Section requirements that are no longer enforced: service intention
+    // id and Requirement::id.
+    std::vector<std::pair<std::string, std::string>> droppedRequirements;
+};
+
+// Reads a JSON array of scenarios:
+//   [{"name": ..., "closed_resources": [...], "cancelled_trains": [...],
+//     "dropped_requirements": [{"service_intention": ..., "sequence_number": ...}]}]
+bool readScenarios(const char *file, std::vector<Scenario> &scenarios, std::string &error);
+
+#if MAXSATNID==1
+
+struct ScenarioOutcome {
+    StatusCode status = _UNKNOWN_;
+    bool timedOut = false;
+    uint64_t cost = 0;
+    std::string error;
+    std::vector<lbool> model;
+    // Groups whose state in an infeasible scenario (switched off or still
+    // active) explains why, e.g. "train 111" or "resource R1".
+    std::vector<std::string> conflict;
+    // Groups violated by the solution in relaxation mode (see
+    // Timetabler::relax), besides those the scenario switched off.
+    std::vector<std::string> relaxed;
+};
+
+// Solves many scenarios of one request on a single encoding. The request is
+// encoded once with activation variables (Timetabler::activations), and
+// every scenario is the set of assumptions switching its groups off. Each
+// thread clones the SAT solver of the encoding once and checks all its
+// scenarios on it incrementally, which also explains infeasible ones with a
+// group MUS (see Timetabler::groupMUS) of at most 'musPropagations'. The
+// feasible ones are optimised by a MaxSAT algorithm on a copy of the
+// encoding, under the same assumptions. In relaxation mode, the trains and
+// requirements a scenario keeps are not assumed active, so that they can be
+// violated when the scenario is infeasible as specified.
+class ScenarioSolver {
+public:
+    typedef std::function<openwbo::MaxSAT *(openwbo::MaxSATFormula *)> AlgorithmFactory;
+
+    // 'request' must be encoded with 'activations' set.
+    ScenarioSolver(Timetabler &request, AlgorithmFactory newAlgorithm, double timeLimit, int threads,
+                   int64_t musPropagations = defaultMUSPropagations)
+            : request(request), newAlgorithm(newAlgorithm), timeLimit(timeLimit), threads(threads),
+              musPropagations(musPropagations) {}
+
+    // Propagations of a group MUS, as the default budget of the Muser of
+    // MaxHS.
+    static const int64_t defaultMUSPropagations = 10 * 1024 * 1024;
+
+    // 'timeLimit' applies to each scenario.
+    void solve(const std::vector<Scenario> &scenarios, std::vector<ScenarioOutcome> &outcomes);
+
+private:
+    bool assumptions(const Scenario &scenario, vec<Lit> &lits, std::string &error);
+    void solve(Solver *solver, const vec<Lit> &lits, ScenarioOutcome &outcome);
+
+    Timetabler &request;
+    AlgorithmFactory newAlgorithm;
+    double timeLimit;
+    int threads;
+    int64_t musPropagations;
+};
+
+#endif
+
+#endif //TRAIN_SCHEDULE_OPTIMISATION_SCENARIOS_H
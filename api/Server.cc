@@ -0,0 +1,210 @@
+/*!
+ * Timetabler Copyright (c) 2019 Alexandre Lemos, Pedro T Monteiro, Ines Lynce
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef MAXSATNID
+#define MAXSATNID 1
+#endif
+
+#include "Server.h"
+
+#if MAXSATNID==1
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <chrono>
+#include <cinttypes>
+
+using namespace openwbo;
+
+int Server::serveStdin() {
+    fflush(stdout);
+    int fd = dup(STDOUT_FILENO);
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    FILE *out = fdopen(fd, "w");
+    if (out == NULL) {
+        perror("c Error: server");
+        return _ERROR_;
+    }
+    serve(stdin, out);
+    fclose(out);
+    return 0;
+}
+
+int Server::serveSocket(const char *path) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        printf("c Error: socket path too long: %s\n", path);
+        return _ERROR_;
+    }
+    strcpy(addr.sun_path, path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);
+    if (listener < 0 || bind(listener, (sockaddr *) &addr, sizeof(addr)) < 0 || listen(listener, 16) < 0) {
+        perror("c Error: server");
+        return _ERROR_;
+    }
+    // A client going away must not take the server with it.
+    signal(SIGPIPE, SIG_IGN);
+    printf("c Listening on %s\n", path);
+    fflush(stdout);
+
+    bool running = true;
+    while (running) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("c Error: server");
+            break;
+        }
+        FILE *in = fdopen(fd, "r");
+        FILE *out = fdopen(dup(fd), "w");
+        if (in != NULL && out != NULL)
+            running = serve(in, out);
+        if (in != NULL)
+            fclose(in);
+        else
+            close(fd);
+        if (out != NULL)
+            fclose(out);
+    }
+    close(listener);
+    unlink(path);
+    return 0;
+}
+
+bool Server::serve(FILE *in, FILE *out) {
+    char *line = NULL;
+    size_t n = 0;
+    bool running = true;
+    while (getline(&line, &n, in) > 0) {
+        char command[16];
+        long bytes = 0;
+        double limit = options.timeLimit;
+        int fields = sscanf(line, "%15s %ld %lf", command, &bytes, &limit);
+        if (fields < 1)
+            continue;
+        if (strcmp(command, "QUIT") == 0)
+            break;
+        if (strcmp(command, "SHUTDOWN") == 0) {
+            running = false;
+            break;
+        }
+        if (strcmp(command, "SOLVE") != 0 || fields < 2 || bytes <= 0) {
+            fprintf(out, "ERROR invalid request\n");
+            fflush(out);
+            continue;
+        }
+        std::string json(bytes, '\0');
+        if (fread(&json[0], 1, bytes, in) != (size_t) bytes) {
+            fprintf(out, "ERROR truncated request\n");
+            fflush(out);
+            break;
+        }
+        solve(json, limit, out);
+    }
+    free(line);
+    return running;
+}
+
+void Server::sendSolution(Timetabler &request, uint64_t cost, FILE *out) {
+    std::string json;
+    request.decodeModel(request.S->model);
+    request.writeJSON(json);
+    fprintf(out, "SOLUTION %" PRIu64 " %zu\n", cost, json.size());
+    fwrite(json.data(), 1, json.size(), out);
+    fprintf(out, "\n");
+    fflush(out);
+}
+
+void Server::solve(const std::string &json, double limit, FILE *out) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Timetabler request;
+    request.option = options.optTime;
+    request.relax = options.relax;
+    request.delays = options.delays;
+    request.activations = options.diagnose;
+    request.horizon = options.horizon;
+    try {
+        if (!request.readJSON(json.data(), json.size())) {
+            fprintf(out, "ERROR invalid JSON\n");
+            fflush(out);
+            return;
+        }
+        request.genEncoding();
+        request.widenHorizon();
+        request.S = newAlgorithm(request.maxsat_formula);
+        if (request.S == NULL) {
+            fprintf(out, "ERROR invalid MaxSAT algorithm\n");
+            fflush(out);
+            return;
+        }
+        if (options.diagnose) {
+            std::vector<std::string> groups;
+            bool minimal;
+            lbool res = request.diagnose(options.musPropagations, groups, minimal);
+            for (const std::string &group: groups)
+                fprintf(out, "c conflict: %s\n", group.c_str());
+            // Otherwise the relaxed search gives the least-bad plan.
+            if (res == l_False && !options.relax) {
+                fprintf(out, "DONE UNSATISFIABLE\n");
+                fflush(out);
+                return;
+            }
+        }
+        request.computeLowerBound(options.lbConflicts);
+        if (options.gap >= 0)
+            request.stopAtGap(options.gap / 100);
+
+        StatusCode code = request.solve(limit, [&](uint64_t cost) {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            fprintf(out, "PROGRESS %" PRIu64 " %.2f\n", cost, elapsed.count());
+            sendSolution(request, cost, out);
+        });
+
+        const char *status = "UNKNOWN";
+        if (request.timedOut)
+            status = "TIMEOUT";
+        else if (code == _OPTIMUM_)
+            status = "OPTIMUM";
+        else if (code == _SATISFIABLE_)
+            status = "SATISFIABLE";
+        else if (code == _UNSATISFIABLE_)
+            status = "UNSATISFIABLE";
+        fprintf(out, "DONE %s\n", status);
+    } catch (std::runtime_error &e) {
+        fprintf(out, "ERROR %s\n", e.what());
+    } catch (NSPACE::OutOfMemoryException &) {
+        fprintf(out, "ERROR out of memory\n");
+    }
+    fflush(out);
+}
+
+#endif
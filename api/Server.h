@@ -0,0 +1,60 @@
+//
+// Server mode of the timetabler.
+//
+
+#ifndef TRAIN_SCHEDULE_OPTIMISATION_SERVER_H
+#define TRAIN_SCHEDULE_OPTIMISATION_SERVER_H
+
+#include <stdio.h>
+#include <functional>
+#include <string>
+
+#include "libtimetabler.h"
+
+#if MAXSATNID==1
+
+// Solves requests sent over stdin/stdout or a Unix domain socket, one at a
+// time, without paying for a new process per instance. Every request gets
+// its own Timetabler, so nothing leaks from one request into the next, and
+// is solved with the same options (-opt-time, -relax, -delays, -diagnose,
+// -horizon, ...).
+//
+// Requests (one header line, followed by a body of exactly <bytes> bytes):
+//   SOLVE <bytes> [<seconds>]   solve the JSON instance in the body, with an
+//                               optional wall-clock limit for this request
+//   QUIT                        close the connection
+//   SHUTDOWN                    stop the server
+// Replies:
+//   PROGRESS <cost> <seconds>   a new upper bound was found
+//   SOLUTION <cost> <bytes>     followed by the JSON solution of that bound
+//   DONE <status>               OPTIMUM, SATISFIABLE, UNSATISFIABLE, UNKNOWN or
+//                               TIMEOUT (the best solution was already sent)
+//   ERROR <message>
+// Lines starting with "c" are comments. With -diagnose, an infeasible
+// instance is explained by "c conflict: <group>" lines before its DONE.
+class Server {
+public:
+    typedef std::function<openwbo::MaxSAT *(openwbo::MaxSATFormula *)> AlgorithmFactory;
+
+    // 'options.timeLimit' is the default limit of a request, 0 for none.
+    Server(const libtimetabler::Options &options, AlgorithmFactory newAlgorithm)
+            : options(options), newAlgorithm(newAlgorithm) {}
+
+    // Reads requests from stdin and replies on stdout. Everything else the
+    // solvers print is redirected to stderr.
+    int serveStdin();
+    int serveSocket(const char *path);
+
+private:
+    // Returns false when the client asked for a SHUTDOWN.
+    bool serve(FILE *in, FILE *out);
+    void solve(const std::string &json, double limit, FILE *out);
+    void sendSolution(Timetabler &request, uint64_t cost, FILE *out);
+
+    libtimetabler::Options options;
+    AlgorithmFactory newAlgorithm;
+};
+
+#endif
+
+#endif //TRAIN_SCHEDULE_OPTIMISATION_SERVER_H
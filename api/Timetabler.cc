@@ -0,0 +1,2346 @@
+/*!
+ * Timetabler Copyright (c) 2019 Alexandre Lemos, Pedro T Monteiro, Ines Lynce
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef MAXSATNID
+#define MAXSATNID 1
+#endif
+
+#include "Timetabler.h"
+
+#include <limits.h>
+#include <math.h>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#if MAXSATNID<5
+#include <atomic>
+#include <thread>
+#endif
+#if MAXSATNID==1
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include "ClauseCache.h"
+#include "Portfolio.h"
+#include "../solver/TT-Open-WBO-Inc/Encoder.h"
+#endif
+
+#include "../rapidjson/istreamwrapper.h"
+#include "../rapidjson/stringbuffer.h"
+#include "../rapidjson/prettywriter.h"
+
+using namespace rapidjson;
+using namespace std;
+#if MAXSATNID<5
+using namespace openwbo;
+#endif
+
+Timetabler::Timetabler() {
+    minV = INT_MAX;
+    maxV = 0;
+    diffV = 0;
+    size = -1;
+    ownsInstance = false;
+#if MAXSATNID<5
+    option = 2;
+    activations = false;
+    relax = false;
+    delays = false;
+    horizon = 0;
+    encodeThreads = 1;
+    lowerBound = 0;
+    maxsat_formula = NULL;
+    S = NULL;
+#endif
+#if MAXSATNID==1
+    timedOut = false;
+    freedTrains = 0;
+    checkpointInterval = 0;
+    searchCost = UINT64_MAX;
+    resumedLearnts = 0;
+    clauseCache = NULL;
+    broker = NULL;
+    sentLB = 0;
+    nextSync = 0;
+    gap = -1;
+    gapStatus = _UNKNOWN_;
+    enumerating = NULL;
+    interrupted = false;
+#endif
+}
+
+Timetabler::~Timetabler() {
+#if MAXSATNID<5
+    if (S != NULL) {
+        if (S->getMaxSATFormula() != maxsat_formula)
+            delete maxsat_formula;
+        delete S;
+    } else if (maxsat_formula != NULL)
+        delete maxsat_formula;
+#endif
+    clearResults();
+    for (Requirement *r: ownedRequirements)
+        delete r;
+    if (!ownsInstance)
+        return;
+    std::map<std::string,std::map<int,route_section*>>::iterator it = instance.sectionMap.begin();
+    while (it != instance.sectionMap.end()) {
+        std::map<int,route_section*>::iterator it1 = it->second.begin();
+        while (it1 != it->second.end()) {
+            delete it1->second;
+            it1++;
+        }
+        it++;
+    }
+    for (int j = 0; j < instance.train.size(); ++j)
+        for (Requirement *r: instance.train[j].t)
+            delete r;
+}
+
+void Timetabler::clearResults() {
+    std::map<std::string,std::map<int,train_run_sections*>>::iterator it = instance.results.begin();
+    while (it != instance.results.end()) {
+        std::map<int,train_run_sections*>::iterator it1 = it->second.begin();
+        while (it1 != it->second.end()) {
+            delete it1->second;
+            it1++;
+        }
+        it++;
+    }
+    instance.results.clear();
+}
+
+bool Timetabler::readJSONFile(const char *local) {
+    ifstream ifs(local);
+    if (!ifs.is_open())
+        return false;
+    IStreamWrapper isw(ifs);
+    Document d;
+    d.ParseStream(isw);
+    if (d.HasParseError() || !d.IsObject())
+        return false;
+    instance = parseInstance(d);
+    ownsInstance = true;
+    return true;
+}
+
+bool Timetabler::readJSON(const char *buffer, size_t length) {
+    Document d;
+    d.Parse(buffer, length);
+    if (d.HasParseError() || !d.IsObject())
+        return false;
+    instance = parseInstance(d);
+    ownsInstance = true;
+    return true;
+}
+
+bool Timetabler::readPESPFile(const char *local, int period, std::string &error) {
+    ifstream infile(local);
+    if (!infile.is_open()) {
+        error = std::string("could not read ") + local;
+        return false;
+    }
+    periodic = PeriodicInstance();
+    periodic.period = period;
+    std::string name = local;
+    name = name.substr(name.find_last_of('/') + 1);
+    periodic.label = name.substr(0, name.find('.'));
+    std::map<std::string, int> events;
+    std::string line;
+    for (int n = 1; std::getline(infile, line); n++) {
+        std::string lower = line;
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        if (lower.find("period") != std::string::npos) {
+            size_t digit = lower.find_first_of("0123456789");
+            if (digit != std::string::npos)
+                periodic.period = atoi(lower.c_str() + digit);
+            continue;
+        }
+        line = line.substr(0, line.find('#'));
+        std::replace(line.begin(), line.end(), ';', ' ');
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream iss(line);
+        std::string id, from, to;
+        PeriodicActivity a;
+        if (!(iss >> id))
+            continue;
+        if (!(iss >> from >> to >> a.lower >> a.upper >> a.weight) || a.lower > a.upper || a.weight < 0) {
+            error = std::string(local) + ":" + std::to_string(n) + ": invalid activity";
+            return false;
+        }
+        a.id = id;
+        for (int k = 0; k < 2; k++) {
+            const std::string &event = k == 0 ? from : to;
+            std::map<std::string, int>::iterator it = events.find(event);
+            if (it == events.end()) {
+                it = events.insert(std::make_pair(event, (int) periodic.events.size())).first;
+                periodic.events.push_back(event);
+            }
+            (k == 0 ? a.from : a.to) = it->second;
+        }
+        periodic.activities.push_back(a);
+    }
+    if (periodic.period <= 0) {
+        error = std::string(local) + ": the period must be positive";
+        return false;
+    }
+    return true;
+}
+
+void Timetabler::setInstance(const Instance &in) {
+    instance = in;
+    instance.results.clear();
+    ownsInstance = false;
+    minV = INT_MAX;
+    maxV = 0;
+    diffV = 0;
+    size = -1;
+    for (int j = 0; j < instance.train.size(); ++j) {
+        for (Requirement *r: instance.train[j].t) {
+            if(minV > r->sec_entry_earliest&&r->sec_entry_earliest !=-1)
+                minV=r->sec_entry_earliest;
+            if(maxV < r->sec_exit_latest &&r->sec_exit_latest !=-1)
+                maxV=r->sec_exit_latest;
+        }
+    }
+    if(diffV<(minV-maxV))
+        diffV=(minV-maxV);
+    std::map<std::string,std::map<int,route_section*>>::iterator it = instance.sectionMap.begin();
+    while (it != instance.sectionMap.end()) {
+        size += it->second.size();
+        it++;
+    }
+}
+
+Instance Timetabler::parseInstance(Document &d) {
+    Instance Instance;
+
+    Instance.hash=d["hash"].GetInt();
+    Instance.label=d["label"].GetString();
+    std::vector<Train> tt;
+    std::map<std::string, double > route_pen;
+    for (int i = 0; i < d["service_intentions"].GetArray().Size(); ++i) {
+        Train train;
+        if(d["service_intentions"].GetArray()[i]["id"].IsInt())
+            train.id=std::to_string(d["service_intentions"].GetArray()[i]["id"].GetInt());
+        else
+            train.id=d["service_intentions"].GetArray()[i]["id"].GetString();
+
+        if(d["service_intentions"].GetArray()[i]["route"].IsInt())
+            train.route=std::to_string(d["service_intentions"].GetArray()[i]["route"].GetInt());
+        else
+            train.route=d["service_intentions"].GetArray()[i]["route"].GetString();
+        std::vector<Requirement*> re;
+
+        for (int j = 0; j <d["service_intentions"].GetArray()[i]["section_requirements"].GetArray().Size() ; ++j) {
+            string id="",delay="";
+            string entry_ea="",exit_earliest="",type="",min_stopping_time="",marker="",exit_latest="",entry_latest="";
+            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("entry_latest"))
+                entry_latest=d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["entry_latest"].GetString();
+            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("exit_latest"))
+                exit_latest=d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["exit_latest"].GetString();
+
+            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("entry_earliest"))
+                entry_ea=d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["entry_earliest"].GetString();
+            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("exit_earliest"))
+                exit_earliest=d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["exit_earliest"].GetString();
+
+            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("section_marker"))
+                marker=d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["section_marker"].GetString();
+            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("type"))
+                type=d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["type"].GetString();
+
+
+            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("min_stopping_time"))
+                min_stopping_time=d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["min_stopping_time"].GetString();
+            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("sequence_number")){
+               if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["sequence_number"].IsInt())
+                   id=std::to_string(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["sequence_number"].GetInt());
+                else
+                   id = d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["sequence_number"].GetString();
+
+
+            }
+
+            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("entry_delay_weight")) {
+                if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["entry_delay_weight"].IsInt())
+                    delay=std::to_string(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["entry_delay_weight"].GetInt());
+                else
+                    delay=std::to_string(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["entry_delay_weight"].GetFloat());
+
+            }
+
+            list<connection> clist;
+
+            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("connections")){
+                if(!d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["connections"].IsNull()){
+                    for (int k = 0; k < d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["connections"].GetArray().Size(); ++k) {
+                        if(!d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["connections"].GetArray()[k].IsNull()) {
+                            connection c = connection(
+                                    d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["connections"].GetArray()[k]["onto_service_intention"].GetInt(),
+                                    d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["connections"].GetArray()[k]["onto_section_marker"].GetString(),
+                                    d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["connections"].GetArray()[k]["min_connection_time"].GetString());
+                            clist.push_back(c);
+                        }
+
+                    }
+                }
+            }
+
+
+
+            if(id.compare("")!=0) {
+                Requirement *r = new Requirement(id,
+                                            marker,
+                                            type,
+                                            min_stopping_time,
+                                            entry_ea,
+                                            delay,
+                                            exit_earliest,entry_latest,exit_latest);
+                r->connections = clist;
+                //printf("Marker!: %s \n",marker.c_str());
+                //std::cout <<"now "<< *r << std::endl;
+                //r->toString();
+                if(minV > r->sec_entry_earliest&&r->sec_entry_earliest !=-1)
+                    minV=r->sec_entry_earliest;
+                if(maxV < r->sec_exit_latest &&r->sec_exit_latest !=-1)
+                    maxV=r->sec_exit_latest;
+                if(diffV<(minV-maxV))
+                    diffV=(minV-maxV);
+                if(re.size()>0){
+
+                    //std::cout <<"old "<< *re[re.size()-1] << std::endl;
+                    if(re[re.size()-1]->exit_latest.compare("")==0){
+                        if(r->entry_earliest.compare("")!=0){
+                            re[re.size()-1]->sec_exit_latest=r->sec_entry_earliest;//+re[re.size()-1]->min_stopping_time;
+                            //printf("earl  %d\n",re[re.size()-1]->sec_exit_latest);
+                        } else if(r->exit_latest.compare("")!=0){
+                            re[re.size()-1]->sec_exit_latest=r->sec_exit_latest;//+re[re.size()-1]->min_stopping_time;
+                            //printf("exit %d\n",re[re.size()-1]->sec_exit_latest);
+                        } else {
+                            re[re.size()-1]->sec_exit_latest=r->sec_exit_earliest;//+re[re.size()-1]->min_stopping_time;
+                            //printf("exit %d\n",re[re.size()-1]->sec_exit_earliest);
+                        }
+                    }
+                    if(r->entry_earliest.compare("")==0){
+                        if(re[re.size()-1]->exit_latest.compare("")!=0){
+                            r->sec_entry_earliest=re[re.size()-1]->sec_exit_latest;//+re[re.size()-1]->min_stopping_time;
+                            //printf("exit ow %d\n",r->sec_entry_earliest);
+                        } else  if(re[re.size()-1]->sec_entry_earliest!=-1){
+                            r->sec_entry_earliest=re[re.size()-1]->sec_entry_earliest;//+re[re.size()-1]->min_stopping_time;
+                            //printf("earl ow %d\n",r->sec_entry_earliest);
+                        }
+                    }
+
+
+                }
+                re.push_back(r);
+
+            }
+
+            //if(std::stoi(id)==d["service_intentions"].GetArray()[i]["section_requirements"].GetArray().Size())
+              //  printf("exa: %s l: %s\n",exit_earliest.c_str(),exit_latest.c_str());
+
+
+        }
+        train.t=re;
+
+
+        tt.push_back(train);
+    }
+
+
+    Instance.train=tt;
+    std::map<std::string,Route> rr;
+    std::map<std::string, std::map<int,std::vector<route_section*>>> end1;
+    std::map<std::string,std::vector<route_section*>> entryMap;
+    std::map<std::string,std::vector<route_section*>> exitMap;
+    std::map<std::string,std::vector<route_section*>> markerMap;
+
+    std::map<std::string,std::map<int,route_section*>> secMap;
+
+
+    for (int m = 0; m < d["routes"].GetArray().Size(); ++m) {
+        int nSeq=0;
+       Route r;
+        if(d["routes"].GetArray()[m]["id"].IsInt())
+            r.id=std::to_string(d["routes"].GetArray()[m]["id"].GetInt());
+
+        else
+            r.id=d["routes"].GetArray()[m]["id"].GetString();
+        std::list<route_path> rpl;
+        route_path rp;
+
+        for (int i = 0; i < d["routes"].GetArray()[m]["route_paths"].GetArray().Size(); ++i) {
+            if(d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["id"].IsInt())
+                rp.id=std::to_string(d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["id"].GetInt());
+            else
+                rp.id=d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["id"].GetString();
+            std::list<route_section*> rsl;
+            route_section *rs= new route_section();
+            route_section *rs1= new route_section();
+
+
+            for (int j = 0; j < d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"].GetArray().Size(); j++) {
+                nSeq++;
+                size++;
+                rs->sequence_number = d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["sequence_number"].GetInt();
+                std::list<std::string> temp;
+                if (d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j].HasMember(
+                        "route_alternative_marker_at_entry")) {
+                    for (int k = 0; k <
+                                    d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["route_alternative_marker_at_entry"].GetArray().Size(); ++k) {
+                        std::string e =d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["route_alternative_marker_at_entry"].GetArray()[k].GetString();
+                        temp.push_front(e);
+                    std::string c = e +"^"+ r.id;
+//                            printf("Entry: %s s %d\n",c.c_str(),rs->sequence_number);
+                        if(entryMap.find(c)!=entryMap.end()){
+                            entryMap[c].push_back(rs);
+                        } else {
+                            std::vector<route_section*> rsV;
+                            rsV.push_back(rs);
+                            entryMap.insert(std::pair<std::string,std::vector<route_section*>>(c,rsV));
+                        }
+                    }
+                }
+
+                rs->route_alternative_marker_at_entry = temp;
+                temp.clear();
+                if (d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j].HasMember(
+                        "route_alternative_marker_at_exit")) {
+                    for (int k = 0; k <
+                                    d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["route_alternative_marker_at_exit"].GetArray().Size(); ++k) {
+                        std::string e =d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["route_alternative_marker_at_exit"].GetArray()[k].GetString();
+                        temp.push_front(e);
+                        std::string c = e +"^"+ r.id;
+//                            printf("Exit: %s s %d\n",c.c_str(),rs->sequence_number);
+                        if(exitMap.find(c)!=exitMap.end()){
+                            exitMap[c].push_back(rs);
+                        } else {
+                            std::vector<route_section*> rsV;
+                            rsV.push_back(rs);
+                            exitMap.insert(std::pair<std::string,std::vector<route_section*>>(c,rsV));
+                        }
+                    }
+
+                }
+                rs->route_alternative_marker_at_exit = temp;
+                temp.clear();
+                if (d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j].HasMember(
+                        "section_marker")) {
+                    for (int k = 0; k <
+                                    d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["section_marker"].GetArray().Size(); ++k) {
+                        std::string e = d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["section_marker"].GetArray()[k].GetString();
+                        temp.push_front(e);
+                        std::string c = r.id +"^"+e;
+//                        printf("Marker: %s s %d\n",c.c_str(),rs->sequence_number);
+                        if(markerMap.find(c)!=exitMap.end()){
+                            markerMap[c].push_back(rs);
+                        } else {
+                            std::vector<route_section*> rsV;
+                            rsV.push_back(rs);
+                            markerMap.insert(std::pair<std::string,std::vector<route_section*>>(c,rsV));
+                        }
+
+
+                    }
+                }
+                rs->section_marke = temp;
+                if (d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j].HasMember(
+                        "resource_occupations")) {
+                    std::list<Resource> tempR;
+                    for (int k = 0; k <
+                                    d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["resource_occupations"].GetArray().Size(); ++k) {
+                        Resource r;
+                        if (d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["resource_occupations"].GetArray()[k]["occupation_direction"].IsString())
+                            r = Resource(
+                                    d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["resource_occupations"].GetArray()[k]["resource"].GetString(),
+                                    d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["resource_occupations"].GetArray()[k]["occupation_direction"].GetString());
+                        else
+                            r = Resource(
+                                    d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["resource_occupations"].GetArray()[k]["resource"].GetString());
+
+                        tempR.push_front(r);
+                    }
+                    rs->resource_occupations = tempR;
+                } else {
+                    std::list<Resource> tempR;
+                    rs->resource_occupations = tempR;
+                }
+                if(d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j].HasMember("penalty")) {
+                    if (!d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["penalty"].IsNull())
+                        rs->penalty = d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["penalty"].GetDouble();
+                    else
+                        rs->penalty = 0;
+                } else
+                    rs->penalty = 0;
+                if(rs->penalty != 0)
+                    route_pen.insert(std::pair<std::string, double>(r.id+"^"+std::to_string(rs->sequence_number),rs->penalty));
+                rs->route_pathName=rp.id;
+                rs->starting_point = d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["starting_point"].GetString();
+                rs->minimum_running_time = d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["minimum_running_time"].GetString();
+                rs->ending_point = d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["ending_point"].GetString();
+                if (j > 0) {
+                    //printf("train: %s origin %d dest %d\n",r.id.c_str(),rs1->sequence_number,rs->sequence_number);
+                    auto it = end1.find(r.id);
+                    if (it == end1.end()) {
+                        std::map<int, std::vector < route_section * >> mapEnd;
+                        std::vector<route_section*> t;
+                        t.push_back(rs);
+                        t.push_back(rs1);
+                        mapEnd.insert(std::pair<int, std::vector < route_section * >>(rs->sequence_number,t));
+                        end1.insert(std::pair < std::string, std::map < int,
+                                    std::vector < route_section * >> > (r.id, mapEnd));
+                    } else {
+                        auto it1 = it->second.find(rs->sequence_number);
+                        if (it1 == it->second.end()) {
+                            std::vector<route_section*> t;
+                            t.push_back(rs);
+                            t.push_back(rs1);
+                            it->second.insert(std::pair<int, std::vector < route_section * >>(rs->sequence_number,t));
+                        } else {
+                            it1->second.push_back(rs1);
+                        }
+                    }
+                }
+                if(Instance.pathMap.find(r.id)!=Instance.pathMap.end()){
+                    if(Instance.pathMap[r.id].find(rp.id)!=Instance.pathMap[r.id].end()){
+                        if(Instance.pathMap[r.id][rp.id].find(rs->sequence_number)==Instance.pathMap[r.id][rp.id].end()){
+                            Instance.pathMap[r.id][rp.id].insert(std::pair<int,route_section*>(rs->sequence_number,rs));
+                        }
+                    } else{
+                        std::map<int,route_section*> tempM; tempM.insert(std::pair<int,route_section*>(rs->sequence_number,rs));
+                        Instance.pathMap[r.id].insert(std::pair<std::string,std::map<int,route_section*>>(rp.id, tempM));
+
+                    }
+                } else{
+                    std::map<int,route_section*> tempM; tempM.insert(std::pair<int,route_section*>(rs->sequence_number,rs));
+                    std::map<std::string,std::map<int,route_section*>> tempM1; tempM1.insert(std::pair<std::string,std::map<int,route_section*>>(rp.id,tempM));
+                    Instance.pathMap.insert(std::pair<std::string,std::map<std::string,std::map<int,route_section*>>>(r.id, tempM1));
+
+                }
+
+                rs1=rs;
+
+                if(secMap.find(r.id)!=secMap.end()) {
+                    if (secMap[r.id].find(rs->sequence_number) == secMap[r.id].end()) {
+                        secMap[r.id].insert(std::pair<int,route_section*>(rs->sequence_number,rs));
+                    } else{
+                        printf("OPS: This should not happen: line 959\n");
+                        std::exit(1);
+                    }
+
+                } else {
+                    std::map<int,route_section*> mapT;
+                    mapT.insert(std::pair<int,route_section*>(rs->sequence_number,rs));
+                    secMap.insert(std::pair<std::string,std::map<int,route_section*>>(r.id,mapT));
+                }
+                rsl.push_front(rs1);
+                rs= new route_section();
+
+
+            }
+
+            rp.route_sections=rsl;
+            rpl.push_front(rp);
+
+        }
+        r.route_paths=rpl;
+        r.totalSeq=nSeq;
+        rr.insert(std::pair<std::string,Route>(r.id,r));
+    }
+    Instance.route=rr;
+    Instance.exitMap=exitMap;
+    Instance.entryMap=entryMap;
+    Instance.markerMap=markerMap;
+    Instance.route_pen=route_pen;
+    Instance.sectionMap=secMap;
+    Instance.end=end1;
+
+    std::list<Resource> reso;
+    for (int l = 0; l < d["resources"].GetArray().Size(); ++l) {
+      Resource resource = Resource(d["resources"].GetArray()[l]["id"].GetString(),d["resources"].GetArray()[l]["release_time"].GetString(),d["resources"].GetArray()[l]["following_allowed"].GetBool());
+      reso.push_front(resource);
+
+    }
+    Instance.resource=reso;
+    Instance.maxBandabweichung=d["parameters"].GetObject()["maxBandabweichung"].GetString();
+
+    return Instance;
+}
+
+void Timetabler::writeJSON(std::string &out) {
+    StringBuffer s;
+
+    PrettyWriter<StringBuffer> writer(s);
+    writer.StartObject();               // Between StartObject()/EndObject(),
+    writer.Key("problem_instance_label");                // output a key,
+    writer.String(instance.label.c_str());             // follow by a value.
+    writer.Key("problem_instance_hash");                // output a key,
+    writer.Int(instance.hash);             // follow by a value.
+    writer.Key("hash");                // output a key,
+    writer.Int(42);             // follow by a value.
+    writer.Key("train_runs");
+    writer.StartArray();
+    std::map<std::string,std::map<int,train_run_sections*>> ::iterator it = instance.results.begin();
+    while (it != instance.results.end()) {
+        writer.StartObject();
+        writer.Key("service_intention_id");
+        writer.String(it->first.c_str());
+        writer.Key("train_run_sections");
+        writer.StartArray();
+        std::map<int,train_run_sections*>::iterator it1 = it->second.begin();
+        int j=1;
+        while (it1 != it->second.end()) {
+            writer.StartObject();
+            writer.Key("entry_time");
+            writer.String(it1->second->entry_time.c_str());
+            writer.Key("exit_time");
+            writer.String(it1->second->exit_time.c_str());
+            writer.Key("route");
+            writer.String(it1->second->route.c_str());
+
+            writer.Key("route_section_id");
+            writer.String(it1->second->route_section_id.c_str());
+
+            writer.Key("sequence_number");
+            writer.Int(j);
+
+            writer.Key("route_path");
+            writer.String(it1->second->route_path_str.c_str());
+
+            writer.Key("section_requirement");
+            if(it1->second->section_requirement.size()==0)
+                writer.Null();
+            else
+                writer.String(it1->second->section_requirement.c_str());
+
+
+            writer.EndObject();
+            it1++;
+            j++;
+
+
+        }
+        it++;
+        writer.EndArray();
+        writer.EndObject();
+
+
+
+    }
+
+
+
+    writer.EndArray();
+
+    writer.EndObject();
+
+    out = s.GetString();
+}
+
+void Timetabler::outputJSONFile(const std::string &variant) {
+    std::string out;
+    writeJSON(out);
+
+    //Solution to file
+
+    ofstream myfile;
+    myfile.open ("data/"+instance.label+(variant.empty() ? "" : "."+variant)+".out.json");
+    myfile << out;
+    myfile.close();
+}
+
+#if MAXSATNID<5
+void Timetabler::genEncoding() {
+
+    maxsat_formula = new MaxSATFormula();
+    maxsat_formula->setFormat(_FORMAT_PB_);
+    routeTemplates.clear();
+    slotVars.clear();
+    if (relax)
+        activations = true;
+    // Every train is encoded into its own TrainEncoding, by 'encodeThreads'
+    // workers, then merged in the order of the trains, so the encoding does
+    // not depend on the number of threads. The workers only read the
+    // templates, which are built before. The trains are merged first, so
+    // that the variables of each train form one block (see 'mergeEncoding').
+    for (const Train &train: instance.train)
+        routeTemplate(train.route);
+    std::vector<TrainEncoding *> encodings(instance.train.size());
+    std::atomic<int> next(0);
+    auto work = [&]() {
+        for (int j = next++; j < (int) instance.train.size(); j = next++) {
+            encodings[j] = new TrainEncoding();
+            trainEncoding = encodings[j];
+            encodeTrain(instance.train[j]);
+            trainEncoding = NULL;
+        }
+    };
+    int threads = encodeThreads > 0 ? encodeThreads : std::thread::hardware_concurrency();
+    threads = std::min(threads, (int) instance.train.size());
+    if (threads <= 1) {
+        work();
+    } else {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++)
+            workers.push_back(std::thread(work));
+        for (std::thread &w: workers)
+            w.join();
+    }
+    PBObjFunction delayCosts;
+    for (TrainEncoding *encoding: encodings) {
+        mergeEncoding(*encoding, &delayCosts);
+        delete encoding;
+    }
+
+    //stat(instance,diffV);
+    //std::exit(1);
+
+    std::map<std::string, std::map<int,std::vector<route_section*>>>::iterator
+    it = instance.end.begin();;
+
+    while (it != instance.end.end()) {
+            std::map<int,std::vector<route_section*>>::iterator it1 = it->second.begin();
+            while (it1 != it->second.end()) {
+                if(it1->second[0]->route_alternative_marker_at_entry.size()==0){
+                    vec<Lit> lit;
+                    lit.push(~mkLit(getVariableID("t^"+it->first+"^"+std::to_string(it1->first))));
+                    //printf("~%s ",("t^"+it->first+"^"+std::to_string(it1->first)).c_str());
+                    for (int i = 1; i < it1->second.size(); ++i) {
+                        lit.push(mkLit(getVariableID("t^"+it->first+"^"+std::to_string(it1->second[i]->sequence_number))));
+                        //printf("%s ",("t^"+it->first+"^"+std::to_string(it1->second[i]->sequence_number)).c_str());
+
+                    }
+                    //printf("\n");
+                    //maxsat_formula->addHardClause(lit);
+                    lit.clear();
+                }
+                it1++;
+
+            }
+            it++;
+
+        }
+    std::string delimiter = "^";
+    std::map<std::string,std::vector<route_section*>> ::iterator
+    it2 = instance.entryMap.begin();;
+
+    while (it2 != instance.entryMap.end()) {
+            for(int y=0; y<it2->second.size();y++) {
+                vec <Lit> lit;
+                std::string rid = it2->first.substr(it2->first.find(delimiter) + 1, it2->first.size());
+                if(instance.exitMap[it2->first].size()>0) {
+                    lit.push(~mkLit(getVariableID("t^" + rid + "^" + std::to_string(it2->second[y]->sequence_number))));
+                    //printf("~%s ", ("t^" + rid + "^" + std::to_string(it2->second[y]->sequence_number)).c_str());
+                    for (int i = 0; i < instance.exitMap[it2->first].size(); ++i) {
+                        lit.push(mkLit(getVariableID(
+                                "t^" + rid + "^" + std::to_string(instance.exitMap[it2->first][i]->sequence_number))));
+                        //printf("%s ", ("t^" + rid + "^" + std::to_string(instance.exitMap[it2->first][i]->sequence_number)).c_str());
+
+                    }
+                    //printf("\n");
+                    //maxsat_formula->addHardClause(lit);
+                    lit.clear();
+                }
+            }
+            it2++;
+
+
+
+        }
+
+    std::map<std::string, double >::iterator itpen = instance.route_pen.begin();;
+    PBObjFunction of;
+    while (itpen != instance.route_pen.end()) {
+            //vec<Lit> litpen;
+            std::string rid = itpen->first.substr(0, itpen->first.find(delimiter));
+            std::string section = itpen->first.substr(itpen->first.find(delimiter) + 1, itpen->first.size());
+            //litpen.push(mkLit(getVariableID("t^" + rid + "^" + section)));
+
+            //printf("%f %s \n",itpen->second,("t^" + rid + "^" + section).c_str());
+            of.addProduct(mkLit(getVariableID(
+                    "t^" + rid + "^" + section)),ceil(itpen->second));
+            //maxsat_formula->addSoftClause(100,litpen);
+            //litpen.clear();
+            itpen++;
+        }
+    for (int i = 0; i < delayCosts._lits.size(); i++)
+        of.addProduct(delayCosts._lits[i], delayCosts._coeffs[i]);
+    if (relax)
+        encodeRelaxation(&of);
+    if(of._lits.size()!=0)
+            maxsat_formula->addObjFunction(&of);
+}
+
+thread_local Timetabler::TrainEncoding *Timetabler::trainEncoding = NULL;
+
+// Constraints of the train alone, into 'trainEncoding'.
+void Timetabler::encodeTrain(const Train &train) {
+    encodeMusts(train);
+    trainEncoding->timeVars = encodeTimes(train);
+    if (activations)
+        encodeActivations(train);
+    if (delays && option == 2)
+        encodeDelays(train, &trainEncoding->objective);
+}
+
+void Timetabler::mergeEncoding(TrainEncoding &encoding, PBObjFunction *of) {
+    MaxSATFormula &from = encoding.formula;
+    // The variables of the train are new: they take the next identifiers,
+    // in their order in 'from', so that its block of slots (see 'slotLit')
+    // stays one block. The resource variables shared with other trains
+    // (a^resource^<id>) come after them, unless they exist already.
+    std::vector<int> vars(from.nVars(), var_Undef);
+    std::vector<indexMap::const_iterator> shared;
+    for (indexMap::const_iterator it = from.getIndexToName().begin(); it != from.getIndexToName().end(); it++)
+        if (it->second.compare(0, 11, "a^resource^") == 0)
+            shared.push_back(it);
+        else
+            vars[it->first] = maxsat_formula->addVarName(it->second);
+    for (indexMap::const_iterator it: shared)
+        vars[it->first] = maxsat_formula->addVarName(it->second);
+    vec<Lit> lits;
+    auto translate = [&](const vec<Lit> &local) {
+        lits.clear();
+        for (int i = 0; i < local.size(); i++)
+            lits.push(mkLit(vars[var(local[i])], sign(local[i])));
+    };
+    for (int i = 0; i < from.nHard(); i++) {
+        translate(from.getHardClause(i).clause);
+        maxsat_formula->addHardClause(lits);
+        hardOwner.push_back(encoding.hardOwner[i]);
+    }
+    for (int i = 0; i < from.nCard(); i++) {
+        Card *card = from.getCardinalityConstraint(i);
+        translate(card->_lits);
+        vec<uint64_t> coeffs(lits.size(), 1);
+        PB pb(lits, coeffs, card->_rhs, true);
+        maxsat_formula->addPBConstraint(&pb);
+        cardOwner.push_back(encoding.cardOwner[i]);
+        delete card;
+    }
+    for (int i = 0; i < from.nPB(); i++) {
+        PB *p = from.getPBConstraint(i);
+        translate(p->_lits);
+        PB pb(lits, p->_coeffs, p->_rhs, p->_sign);
+        maxsat_formula->addPBConstraint(&pb);
+        pbOwner.push_back(encoding.pbOwner[i]);
+        delete p;
+    }
+    translate(encoding.objective._lits);
+    for (int i = 0; i < lits.size(); i++)
+        of->addProduct(lits[i], encoding.objective._coeffs[i]);
+}
+
+void Timetabler::genPESPEncoding() {
+    maxsat_formula = new MaxSATFormula();
+    maxsat_formula->setFormat(_FORMAT_PB_);
+    int period = periodic.period;
+    periodicVars.assign(periodic.events.size(), std::vector<int>());
+    for (size_t e = 0; e < periodic.events.size(); e++)
+        for (int k = 1; k < period; k++) {
+            periodicVars[e].push_back(getVariableID("p^" + periodic.events[e] + "^" + std::to_string(k)));
+            if (k == 1)
+                continue;
+            vec<Lit> lit;
+            lit.push(~periodicLit(e, k));
+            lit.push(periodicLit(e, k - 1));
+            maxsat_formula->addHardClause(lit);
+            hardOwner.push_back("");
+        }
+
+    PBObjFunction of;
+    for (const PeriodicActivity &a: periodic.activities) {
+        int span = std::min(a.upper - a.lower, period - 1);
+        int lower = ((a.lower % period) + period) % period;
+        vec<Lit> tension;// tension[t - 1]: at least lower + t
+        for (int t = 1; a.weight > 0 && t <= span; t++) {
+            tension.push(mkLit(getVariableID("w^" + a.id + "^" + std::to_string(t))));
+            of.addProduct(tension.last(), a.weight);
+            if (t == 1)
+                continue;
+            vec<Lit> lit;
+            lit.push(~tension.last());
+            lit.push(tension[t - 2]);
+            maxsat_formula->addHardClause(lit);
+            hardOwner.push_back("");
+        }
+        for (int v = 0; v < period; v++) {
+            // The source of the activity is not at 'v' ...
+            vec<Lit> clause;
+            if (v > 0)
+                clause.push(~periodicLit(a.from, v));
+            if (v + 1 < period)
+                clause.push(periodicLit(a.from, v + 1));
+            // ... or its target is in the window [start, start + span]
+            int start = (v + lower) % period;
+            if (span < period - 1)
+                addPeriodicClause(clause, a.to, start + span + 1, period - span - 2);
+            // ... and the tension is at least lower + t from start + t on.
+            for (int t = 1; t <= tension.size(); t++) {
+                clause.push(tension[t - 1]);
+                addPeriodicClause(clause, a.to, start + t, span - t);
+                clause.pop();
+            }
+        }
+    }
+    if (of._lits.size() != 0)
+        maxsat_formula->addObjFunction(&of);
+    printf("c PESP: %d events, %d activities, period %d\n", (int) periodic.events.size(),
+           (int) periodic.activities.size(), period);
+}
+
+Lit Timetabler::periodicLit(int event, int k) {
+    return mkLit(periodicVars[event][k - 1]);
+}
+
+void Timetabler::addPeriodicClause(const vec<Lit> &clause, int event, int from, int length) {
+    int period = periodic.period;
+    from %= period;
+    int to = from + length;
+    // [from, to] mod period, as one or two intervals of [0, period)
+    int intervals[2][2] = {{from, std::min(to, period - 1)}, {0, to - period}};
+    for (int i = 0; i < 2; i++) {
+        int lo = intervals[i][0], hi = intervals[i][1];
+        if (hi < lo)
+            continue;
+        vec<Lit> lit;
+        clause.copyTo(lit);
+        if (lo > 0)
+            lit.push(~periodicLit(event, lo));
+        if (hi + 1 < period)
+            lit.push(periodicLit(event, hi + 1));
+        // The source and the target of an activity may be the same event:
+        // the backends expect clauses without repeated literals.
+        int size = 0;
+        bool tautology = false;
+        for (int k = 0; k < lit.size(); k++) {
+            bool repeated = false;
+            for (int q = 0; q < size; q++) {
+                repeated = repeated || lit[q] == lit[k];
+                tautology = tautology || lit[q] == ~lit[k];
+            }
+            if (!repeated)
+                lit[size++] = lit[k];
+        }
+        lit.shrink(lit.size() - size);
+        if (tautology)
+            continue;
+        maxsat_formula->addHardClause(lit);
+        hardOwner.push_back("");
+    }
+}
+
+uint64_t Timetabler::outputPESPFile(const vec<lbool> &model) {
+    periodic.times.assign(periodic.events.size(), 0);
+    for (size_t e = 0; e < periodic.events.size(); e++)
+        for (int k = 1; k < periodic.period; k++)
+            if (periodicVars[e][k - 1] < model.size() && model[periodicVars[e][k - 1]] == l_True)
+                periodic.times[e] = k;
+    uint64_t cost = 0;
+    for (const PeriodicActivity &a: periodic.activities) {
+        int slack = periodic.times[a.to] - periodic.times[a.from] - a.lower;
+        slack = ((slack % periodic.period) + periodic.period) % periodic.period;
+        cost += (uint64_t) a.weight * (a.lower + slack);
+    }
+
+    ofstream myfile;
+    myfile.open("data/" + periodic.label + ".timetable");
+    for (size_t e = 0; e < periodic.events.size(); e++)
+        myfile << periodic.events[e] << "; " << periodic.times[e] << "\n";
+    myfile.close();
+    return cost;
+}
+
+// Order literals of the entry times of the train, see 'delays'. With
+// -opt-time=2, the entry time variables s^<train>^<t>^<marker> of a
+// requirement cover [entry earliest, exit latest), or its window (see
+// 'horizon').
+void Timetabler::encodeDelays(const Train &train, PBObjFunction *of, bool clauses) {
+    for (Requirement *r: train.t)
+        encodeDelays(train, r, r->sec_entry_earliest, windowEnd(train, r), of, clauses);
+}
+
+void Timetabler::encodeDelays(const Train &train, Requirement *r, int from, int to, PBObjFunction *of,
+                              bool clauses) {
+    int earliest = r->sec_entry_earliest, end = r->sec_exit_latest;
+    if (earliest < 0 || end <= earliest)
+        return;// no times
+    uint64_t weight = ceil(atof(r->entry_delay_weight.c_str()));
+    int latest = r->sec_entry_latest;
+    if (weight == 0 || latest < 0 || latest + 1 >= end)
+        latest = end;// no delay cost
+    std::string name = train.id + "^" + r->section_marker;
+    // A delay costs 'weight' per order literal "entered at or after
+    // latest + 1 + k * delayStep" inside the window.
+    for (int t = latest + 1; of != NULL && t < to; t += delayStep)
+        if (from == earliest || t >= from)// else costed with the times before 'from'
+            of->addProduct(entryLit(train, r, std::max(t, earliest)), weight);
+    if (!clauses)
+        return;
+    // The next requirement of the train is entered 'stay' seconds after
+    // this one at the earliest.
+    Requirement *next = NULL;
+    for (size_t i = 0; i + 1 < train.t.size(); i++)
+        if (train.t[i] == r && train.t[i + 1]->sec_entry_earliest >= 0 &&
+            train.t[i + 1]->sec_exit_latest > train.t[i + 1]->sec_entry_earliest)
+            next = train.t[i + 1];
+    int stay = next != NULL ? minimumStay(train, r) : 0;
+    // The requirement is entered at one of its times, and an entry at
+    // 't' is after every order literal below 't'. A window ending before
+    // the latest exit leaves the later times to its horizon literal.
+    vec<Lit> entry;
+    if (from > earliest)
+        entry.push(~mkLit(getVariableID("h^" + name)));
+    if (to < end)
+        entry.push(mkLit(getVariableID("h^" + name)));
+    for (int t = from; t < to; t++) {
+        Lit time = mkLit(getVariableID("s^" + train.id + "^" + std::to_string(t) + "^" + r->section_marker));
+        entry.push(time);
+        vec<Lit> lit;
+        // Entered at 't': at or after 't', and not at or after 't + 1'.
+        if (t > earliest || latest < earliest) {
+            lit.push(~time);
+            lit.push(entryLit(train, r, t));
+            addHardClause(lit, train.id);
+            lit.clear();
+        }
+        lit.push(~time);
+        lit.push(~entryLit(train, r, t + 1));
+        addHardClause(lit, train.id);
+        lit.clear();
+        if (next != NULL && t + stay > next->sec_entry_earliest) {
+            lit.push(~time);
+            lit.push(entryLit(train, next, std::min(t + stay, next->sec_exit_latest)));
+            addHardClause(lit, train.id);
+        }
+    }
+    if (activations) {
+        entry.push(~mkLit(getVariableID("a^train^" + train.id)));
+        entry.push(~mkLit(getVariableID("a^requirement^" + train.id + "^" + r->id)));
+    }
+    addHardClause(entry, train.id);
+    if (from > earliest)
+        return;// the order literals are chained, see below
+    for (int t = latest < earliest ? earliest + 1 : earliest + 2; t <= end; t++) {
+        vec<Lit> lit;
+        lit.push(~entryLit(train, r, t));
+        lit.push(entryLit(train, r, t - 1));
+        addHardClause(lit, train.id);
+    }
+    if (to == end)
+        return;
+    // The horizon literal: entered at or after the end of the window.
+    vec<Lit> lit;
+    lit.push(~mkLit(getVariableID("h^" + name)));
+    lit.push(entryLit(train, r, to));
+    addHardClause(lit, train.id);
+    if (next != NULL && to + stay > next->sec_entry_earliest) {
+        lit.pop();
+        lit.push(entryLit(train, next, std::min(to + stay, next->sec_exit_latest)));
+        addHardClause(lit, train.id);
+    }
+}
+
+Lit Timetabler::entryLit(const Train &train, const Requirement *r, int t) {
+    return mkLit(getVariableID("e^" + train.id + "^" + r->section_marker + "^" + std::to_string(t)));
+}
+
+// Seconds of an ISO 8601 duration of the instance, e.g. PT1M30S.
+int Timetabler::seconds(const std::string &duration) {
+    int total = 0, value = 0;
+    for (size_t i = duration.find('T') + 1; i > 0 && i < duration.size(); i++) {
+        char c = duration[i];
+        if (c >= '0' && c <= '9')
+            value = value * 10 + (c - '0');
+        else {
+            total += value * (c == 'H' ? 3600 : c == 'M' ? 60 : c == 'S' ? 1 : 0);
+            value = 0;
+        }
+    }
+    return total;
+}
+
+int Timetabler::minimumStay(const Train &train, const Requirement *r) {
+    std::map<std::string, std::vector<route_section *>>::iterator sections =
+            instance.markerMap.find(train.route + "^" + r->section_marker);
+    int running = INT_MAX;
+    if (sections != instance.markerMap.end())
+        for (route_section *rs: sections->second)
+            running = std::min(running, seconds(rs->minimum_running_time));
+    return seconds(r->min_stopping_time) + (running == INT_MAX ? 0 : running);
+}
+
+int Timetabler::windowEnd(const Train &train, const Requirement *r) {
+    if (horizon == 0 || !delays || option != 2 || widened.count(train.id + "^" + r->section_marker) > 0)
+        return r->sec_exit_latest;
+    return std::min(r->sec_exit_latest, std::max(r->sec_entry_earliest, r->sec_entry_latest) + horizon);
+}
+
+// Pays for every requirement switched off, and for the requirements of every
+// cancelled train, more than for all the route penalties of a plan.
+void Timetabler::encodeRelaxation(PBObjFunction *of) {
+    uint64_t scale = 1;
+    for (int i = 0; i < of->_coeffs.size(); i++)
+        scale += of->_coeffs[i];
+    for (const Train &train: instance.train) {
+        uint64_t cancel = 0;
+        for (Requirement *r: train.t) {
+            std::string name = "a^requirement^" + train.id + "^" + r->id;
+            std::vector<char> cname(name.begin(), name.end());
+            cname.push_back('\0');
+            int id = maxsat_formula->varID(&cname[0]);
+            if (id == var_Undef)
+                continue;// no section of the requirement, nothing to relax
+            uint64_t weight = std::max(1.0, ceil(atof(r->entry_delay_weight.c_str()))) * scale;
+            of->addProduct(~mkLit(id), weight);
+            cancel += weight;
+        }
+        if (cancel > 0)
+            of->addProduct(~mkLit(getVariableID("a^train^" + train.id)), cancel);
+    }
+}
+
+std::vector<std::string> Timetabler::relaxedGroups(const vec<lbool> &model) {
+    std::vector<std::string> groups;
+    if (!relax)
+        return groups;
+    indexMap::const_iterator it = maxsat_formula->getIndexToName().begin();
+    while (it != maxsat_formula->getIndexToName().end()) {
+        if (it->first < model.size() && model[it->first] == l_False &&
+            (it->second.compare(0, 8, "a^train^") == 0 || it->second.compare(0, 14, "a^requirement^") == 0))
+            groups.push_back(describeGroup(it->second));
+        it++;
+    }
+    return groups;
+}
+
+std::string Timetabler::describeGroup(const std::string &activation) {
+    std::string group = activation.substr(2);
+    std::string kind = group.substr(0, group.find('^'));
+    std::string id = group.substr(group.find('^') + 1);
+    if (kind != "requirement")
+        return kind + " " + id;
+    std::string train = id.substr(0, id.find('^'));
+    std::string requirement = id.substr(id.find('^') + 1);
+    std::string description = "requirement " + requirement + " of train " + train;
+    for (const Train &t: instance.train)
+        if (t.id == train)
+            for (Requirement *r: t.t)
+                if (r->id == requirement)
+                    return description + " (section marker " + r->section_marker + ")";
+    return description;
+}
+
+Timetabler::RouteTemplate &Timetabler::routeTemplate(const std::string &route) {
+    std::map<std::string, RouteTemplate>::iterator found = routeTemplates.find(route);
+    if (found != routeTemplates.end())
+        return found->second;
+    RouteTemplate &t = routeTemplates[route];
+    std::map<int, int> slot;// sequence number -> slot
+    // Sections of a marker may lie outside the sections of the route
+    std::string prefix = route + "^";
+    std::map<std::string, std::vector<route_section *>>::iterator marker = instance.markerMap.lower_bound(prefix);
+    for (; marker != instance.markerMap.end() && marker->first.compare(0, prefix.size(), prefix) == 0; marker++)
+        for (route_section *rs: marker->second) {
+            if (slot.count(rs->sequence_number) == 0) {
+                slot[rs->sequence_number] = t.sequence.size();
+                t.sequence.push_back(rs->sequence_number);
+            }
+            t.markers[marker->first.substr(prefix.size())].push_back(slot[rs->sequence_number]);
+        }
+    t.markerSlots = t.sequence.size();
+    std::map<int, route_section *>::iterator it;
+    for (it = instance.sectionMap[route].begin(); it != instance.sectionMap[route].end(); it++)
+        if (slot.count(it->first) == 0) {
+            slot[it->first] = t.sequence.size();
+            t.sequence.push_back(it->first);
+        }
+    // The shared variables go after the slots.
+    int local = t.sequence.size() + 1;
+    Lit active = mkLit(t.sequence.size());
+    std::map<std::string, int> shared;
+    for (it = instance.sectionMap[route].begin(); it != instance.sectionMap[route].end(); it++) {
+        Lit section = mkLit(slot[it->first]);
+        t.activations.push_back({~section, active});
+        for (const Resource &res: it->second->resource_occupations) {
+            std::string name = "a^resource^" + res.getId();
+            if (shared.count(name) == 0) {
+                shared[name] = t.shared.size();
+                t.shared.push_back(name);
+            }
+            t.activations.push_back({~section, mkLit(local + shared[name])});
+        }
+    }
+    return t;
+}
+
+// Literal of the formula for the literal 'lit' of the template of the route
+// of 'train' instantiated for 'train'. The first call creates the block of
+// the train: the slots of the markers, and the other sections of the route
+// with 'activations', which are the slots its clauses use.
+Lit Timetabler::slotLit(const Train &train, Lit lit) {
+    const RouteTemplate &t = routeTemplate(train.route);
+    int slot = var(lit), slots = t.sequence.size();
+    SlotBlock &block = (trainEncoding != NULL ? trainEncoding->slotVars : slotVars)[train.id];
+    if (block.base == var_Undef) {
+        int used = activations ? slots : t.markerSlots;
+        bool contiguous = true;
+        block.base = target()->nVars();
+        for (int s = 0; s < used; s++) {
+            block.vars.push_back(getVariableID("t^" + train.id + "^" + std::to_string(t.sequence[s])));
+            contiguous = contiguous && block.vars[s] == block.base + s;
+        }
+        if (contiguous)
+            block.vars.clear();
+        block.extra.assign(1 + t.shared.size(), var_Undef);
+    }
+    if (slot < slots)
+        return mkLit(block.vars.empty() ? block.base + slot : block.vars[slot], sign(lit));
+    int &v = block.extra[slot - slots];
+    if (v == var_Undef)
+        v = getVariableID(slot == slots ? "a^train^" + train.id : t.shared[slot - slots - 1]);
+    return mkLit(v, sign(lit));
+}
+
+// At least one section of every section marker of the train.
+void Timetabler::encodeMusts(const Train &train) {
+    const RouteTemplate &t = routeTemplate(train.route);
+    for(Requirement *r: train.t){
+        std::map<std::string, std::vector<int>>::const_iterator marker = t.markers.find(r->section_marker);
+        if (marker == t.markers.end())
+            continue;
+        vec<Lit> lit;
+        for (int slot: marker->second)
+            lit.push(slotLit(train, mkLit(slot)));
+        if(activations) {
+            lit.push(~mkLit(getVariableID("a^train^" + train.id)));
+            lit.push(~mkLit(getVariableID("a^requirement^" + train.id + "^" + r->id)));
+        }
+        addHardClause(lit, train.id);
+    }
+}
+
+// Sections of the train are only used when the train and their resources
+// are active.
+void Timetabler::encodeActivations(const Train &train) {
+    const RouteTemplate &t = routeTemplate(train.route);
+    vec<Lit> lit;
+    for (const std::vector<Lit> &clause: t.activations) {
+        lit.clear();
+        for (Lit l: clause)
+            lit.push(slotLit(train, l));
+        addHardClause(lit, train.id);
+    }
+}
+
+// Time variables of the train, depending on 'option'. Returns their number.
+int Timetabler::encodeTimes(const Train &train) {
+    int timeV=0;
+    if(((int) option) == 0) {
+        int s=0;
+        for(route_path rp: instance.route.at(train.route).route_paths) {
+            for (route_section *rs: rp.route_sections) {
+                PB *p=new PB();
+                for (int i = minV; i < maxV; ++i) {
+                    timeV++;
+                    p->addProduct(mkLit(getVariableID("s^"+train.id+"^"+std::to_string(i)+"^"+std::to_string(s))),1);
+                }
+                if(p->_lits.size()>0)
+                    addPBConstraint(p, train.id);
+                s++;
+
+
+            }
+        }
+    } else if(((int) option) == 1) {
+        int s=0;
+        for(Requirement *r: train.t){
+            PB *p=new PB();
+            for (int i = minV; i < maxV; ++i) {
+                timeV++;
+                p->addProduct(mkLit(getVariableID("s^"+train.id+"^"+std::to_string(i)+"^"+std::to_string(s))),1);
+            }
+            if(p->_lits.size()>0)
+                addPBConstraint(p, train.id);
+            s++;
+
+
+        }
+    } else {
+        for(Requirement *r: train.t){
+            PB *p=new PB();
+            for (int i = r->sec_entry_earliest; i < windowEnd(train, r); ++i) {
+                timeV++;
+                p->addProduct(mkLit(getVariableID("s^"+train.id+"^"+std::to_string(i)+"^"+r->section_marker)),1);
+            }
+            if(p->_lits.size()>0)
+                addPBConstraint(p, train.id);
+            //printf("ee: %d el: %d xe: %d xl: %d\n",r->sec_entry_earliest,r->sec_entry_latest,
+              //         r->sec_exit_earliest,r->sec_exit_latest);
+
+        }
+    }
+    return timeV;
+}
+
+// Adds a copy of 'p' to the encoding, which may store it as a clause, a
+// cardinality or a PB constraint, and records the owner of the new
+// constraint. 'p' is deleted. A constraint every assignment satisfies
+// (the time constraints of 'encodeTimes' are sums >= 0) is left out: the
+// backends encode a cardinality constraint of one literal as a unit clause.
+void Timetabler::addPBConstraint(PB *p, const std::string &train) {
+    if (!p->_sign && p->_rhs <= 0) {
+        delete p;
+        return;
+    }
+    MaxSATFormula *formula = target();
+    int hard = formula->nHard(), card = formula->nCard();
+    formula->addPBConstraint(p);
+    delete p;
+    TrainEncoding *local = trainEncoding;
+    if (formula->nHard() > hard)
+        (local != NULL ? local->hardOwner : hardOwner).push_back(train);
+    else if (formula->nCard() > card)
+        (local != NULL ? local->cardOwner : cardOwner).push_back(train);
+    else
+        (local != NULL ? local->pbOwner : pbOwner).push_back(train);
+}
+
+void Timetabler::addHardClause(vec<Lit> &lit, const std::string &train) {
+    target()->addHardClause(lit);
+    (trainEncoding != NULL ? trainEncoding->hardOwner : hardOwner).push_back(train);
+}
+
+void Timetabler::decodeModel(vec<lbool> &model) {
+    std::string delimiter = "^";
+    clearResults();
+    for (int i = 0; i < model.size(); i++) {
+        indexMap::const_iterator iter = maxsat_formula->getIndexToName().find(i);
+        if (iter == maxsat_formula->getIndexToName().end() || model[i] == l_False)
+            continue;
+        if (iter->second.compare(0, 2, "t^") != 0)
+            continue;
+        std::string id =iter->second.substr(iter->second.find(delimiter) + 1, iter->second.size());
+        std::string sid = id.substr(id.find(delimiter) + 1, id.size());
+        std::string rid = id.substr(0,id.find(delimiter));
+        train_run_sections * trs = new train_run_sections();
+        trs->entry_time="";
+        trs->exit_time="";
+        trs->route=rid;
+        trs->route_section_id=rid+"#"+sid;
+        trs->route_path_str=instance.sectionMap[rid][std::stoi(sid)]->route_pathName;
+        for (int j = 0; j < instance.train.size(); ++j) {
+            if(instance.train[j].id.compare(rid)!=0)
+                continue;
+            for (Requirement *r: instance.train[j].t) {
+                for(int k=0; k<instance.markerMap[instance.train[j].id+"^"+r->section_marker].size();k++) {
+                    if (std::to_string(instance.markerMap[instance.train[j].id+"^"+r->section_marker][k]->sequence_number).compare(sid) == 0) {
+                        trs->section_requirement=r->section_marker;
+                        break;
+                    }
+                }
+            }
+        }
+        instance.results[rid].insert(std::pair<int,train_run_sections*>(std::stoi(sid),trs));
+    }
+}
+
+int Timetabler::getVariableID(const std::string &varName) {
+    return target()->addVarName(varName);
+}
+
+// Creates the first 'n' variables of 'from' in 'to', with the same names and
+// identifiers.
+static void copyVariables(MaxSATFormula *from, int n, MaxSATFormula *to) {
+    for (int i = 0; i < n; i++) {
+        indexMap::const_iterator iter = from->getIndexToName().find(i);
+        if (iter == from->getIndexToName().end()) {
+            to->newVar();
+            continue;
+        }
+        std::vector<char> name(iter->second.begin(), iter->second.end());
+        name.push_back('\0');
+        to->newVarName(&name[0]);
+    }
+}
+
+MaxSATFormula *Timetabler::copyEncoding() {
+    MaxSATFormula *copy = new MaxSATFormula();
+    copy->setFormat(_FORMAT_PB_);
+    copyVariables(maxsat_formula, maxsat_formula->nVars(), copy);
+    for (int i = 0; i < maxsat_formula->nHard(); i++)
+        copy->addHardClause(maxsat_formula->getHardClause(i).clause);
+    for (int i = 0; i < maxsat_formula->nCard(); i++) {
+        Card *card = maxsat_formula->getCardinalityConstraint(i);
+        vec<uint64_t> coeffs(card->_lits.size(), 1);
+        PB pb(card->_lits, coeffs, card->_rhs, true);
+        copy->addPBConstraint(&pb);
+    }
+    for (int i = 0; i < maxsat_formula->nPB(); i++) {
+        PB *p = maxsat_formula->getPBConstraint(i);
+        PB pb(p->_lits, p->_coeffs, p->_rhs, p->_sign);
+        copy->addPBConstraint(&pb);
+    }
+    if (maxsat_formula->getObjFunction() != NULL)
+        copy->addObjFunction(maxsat_formula->getObjFunction());
+    return copy;
+}
+
+// FNV-1a
+static void hashValue(uint64_t &hash, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        hash ^= (value >> (8 * i)) & 0xff;
+        hash *= 1099511628211ULL;
+    }
+}
+
+static void hashLits(uint64_t &hash, const vec<Lit> &lits) {
+    hashValue(hash, lits.size());
+    for (int i = 0; i < lits.size(); i++)
+        hashValue(hash, toInt(lits[i]));
+}
+
+uint64_t Timetabler::encodingHash() {
+    uint64_t hash = 14695981039346656037ULL;
+    hashValue(hash, maxsat_formula->nVars());
+    for (indexMap::const_iterator it = maxsat_formula->getIndexToName().begin();
+         it != maxsat_formula->getIndexToName().end(); it++) {
+        hashValue(hash, it->first);
+        for (char c: it->second)
+            hashValue(hash, c);
+    }
+    for (int i = 0; i < maxsat_formula->nHard(); i++)
+        hashLits(hash, maxsat_formula->getHardClause(i).clause);
+    for (int i = 0; i < maxsat_formula->nCard(); i++) {
+        Card *card = maxsat_formula->getCardinalityConstraint(i);
+        hashLits(hash, card->_lits);
+        hashValue(hash, card->_rhs);
+    }
+    for (int i = 0; i < maxsat_formula->nPB(); i++) {
+        PB *p = maxsat_formula->getPBConstraint(i);
+        hashLits(hash, p->_lits);
+        for (int j = 0; j < p->_coeffs.size(); j++)
+            hashValue(hash, p->_coeffs[j]);
+        hashValue(hash, p->_rhs);
+        hashValue(hash, p->_sign);
+    }
+    PBObjFunction *of = maxsat_formula->getObjFunction();
+    if (of != NULL) {
+        hashLits(hash, of->_lits);
+        for (int j = 0; j < of->_coeffs.size(); j++)
+            hashValue(hash, of->_coeffs[j]);
+        hashValue(hash, of->_const);
+    }
+    return hash;
+}
+
+uint64_t Timetabler::planCost(const vec<lbool> &model) {
+    uint64_t cost = 0;
+    std::map<std::string, double>::iterator itpen = instance.route_pen.begin();
+    while (itpen != instance.route_pen.end()) {
+        std::string rid = itpen->first.substr(0, itpen->first.find("^"));
+        std::string section = itpen->first.substr(itpen->first.find("^") + 1, itpen->first.size());
+        std::string name = "t^" + rid + "^" + section;
+        std::vector<char> cname(name.begin(), name.end());
+        cname.push_back('\0');
+        int id = maxsat_formula->varID(&cname[0]);
+        if (id != var_Undef && id < model.size() && model[id] == l_True)
+            cost += ceil(itpen->second);
+        itpen++;
+    }
+    // Delays and violated requirements, see 'encodeDelays' and
+    // 'encodeRelaxation', and tensions of a PESP instance, see
+    // 'genPESPEncoding'
+    PBObjFunction *of = maxsat_formula->getObjFunction();
+    bool pesp = !periodic.activities.empty();
+    for (int i = 0; (relax || delays || pesp) && of != NULL && i < of->_lits.size(); i++) {
+        Lit l = of->_lits[i];
+        indexMap::const_iterator it = maxsat_formula->getIndexToName().find(var(l));
+        if (it != maxsat_formula->getIndexToName().end() &&
+            (it->second.compare(0, 2, "a^") == 0 || it->second.compare(0, 2, "e^") == 0 ||
+             it->second.compare(0, 2, "w^") == 0) &&
+            var(l) < model.size() && model[var(l)] == (sign(l) ? l_False : l_True))
+            cost += of->_coeffs[i];
+    }
+    return cost;
+}
+
+uint64_t Timetabler::domainLowerBound(std::set<int> &cores) {
+    PBObjFunction *of = maxsat_formula->getObjFunction();
+    if (of == NULL)
+        return 0;
+    std::map<int, uint64_t> weight;// of the penalised variables
+    for (int i = 0; i < of->_lits.size(); i++)
+        if (!sign(of->_lits[i]))
+            weight[var(of->_lits[i])] += of->_coeffs[i];
+
+    uint64_t lb = 0;
+    for (const Train &train: instance.train) {
+        // Requirements of the train whose sections are all penalised, the
+        // most expensive first. Two of them are disjoint cores unless they
+        // share a section.
+        std::vector<std::pair<uint64_t, std::vector<int> > > musts;
+        for (Requirement *r: train.t) {
+            std::vector<route_section*> &sections = instance.markerMap[train.id+"^"+r->section_marker];
+            uint64_t cost = UINT64_MAX;
+            std::vector<int> vars;
+            for (size_t k = 0; k < sections.size() && cost > 0; k++) {
+                std::string name = "t^" + train.id + "^" + std::to_string(sections[k]->sequence_number);
+                std::vector<char> cname(name.begin(), name.end());
+                cname.push_back('\0');
+                int id = maxsat_formula->varID(&cname[0]);
+                std::map<int, uint64_t>::iterator w = weight.find(id);
+                if (id == var_Undef || w == weight.end())
+                    cost = 0;
+                else {
+                    cost = std::min(cost, w->second);
+                    vars.push_back(id);
+                }
+            }
+            if (!sections.empty() && cost > 0)
+                musts.push_back(std::make_pair(cost, vars));
+        }
+        std::sort(musts.begin(), musts.end(),
+                  [](const std::pair<uint64_t, std::vector<int> > &a,
+                     const std::pair<uint64_t, std::vector<int> > &b) { return a.first > b.first; });
+        for (const std::pair<uint64_t, std::vector<int> > &must: musts) {
+            bool disjoint = true;
+            for (int v: must.second)
+                disjoint = disjoint && cores.count(v) == 0;
+            if (!disjoint)
+                continue;
+            cores.insert(must.second.begin(), must.second.end());
+            lb += must.first;
+        }
+    }
+    return lb;
+}
+
+uint64_t Timetabler::computeLowerBound(int64_t probeConflicts) {
+    std::set<int> cores;
+    // A requirement that can be switched off is no core by itself.
+    lowerBound = activations ? 0 : domainLowerBound(cores);
+#if MAXSATNID==1
+    PBObjFunction *of = maxsat_formula->getObjFunction();
+    if (of == NULL || probeConflicts <= 0)
+        return lowerBound;
+    // Every objective literal not in a core yet (a penalised section, a
+    // delay, or ~a^ of a group that may be switched off) is assumed false:
+    // the conflict of an UNSAT call is a core disjoint from the previous
+    // ones, whose cheapest literal is paid for.
+    std::map<int, uint64_t> weight;
+    vec<Lit> assumptions;
+    for (int i = 0; i < of->_lits.size(); i++) {
+        if (of->_coeffs[i] <= 0 || cores.count(var(of->_lits[i])) > 0)
+            continue;
+        if (weight.count(var(of->_lits[i])) == 0)
+            assumptions.push(~of->_lits[i]);
+        weight[var(of->_lits[i])] += of->_coeffs[i];
+    }
+    Solver *solver = buildSATSolver();
+    while (assumptions.size() > 0 && (int64_t) solver->conflicts < probeConflicts) {
+        solver->setConfBudget(probeConflicts - (int64_t) solver->conflicts);
+        // An empty conflict: the hard clauses alone are UNSAT.
+        if (solver->solveLimited(assumptions) != l_False || solver->conflict.size() == 0)
+            break;
+        uint64_t cost = UINT64_MAX;
+        for (int i = 0; i < solver->conflict.size(); i++) {
+            cost = std::min(cost, weight[var(solver->conflict[i])]);
+            cores.insert(var(solver->conflict[i]));
+        }
+        lowerBound += cost;
+        int j = 0;
+        for (int i = 0; i < assumptions.size(); i++)
+            if (cores.count(var(assumptions[i])) == 0)
+                assumptions[j++] = assumptions[i];
+        assumptions.shrink(assumptions.size() - j);
+    }
+    delete solver;
+#endif
+    return lowerBound;
+}
+
+#if MAXSATNID==1
+StatusCode Timetabler::solve(double timeLimit, std::function<void(uint64_t)> progress) {
+    S->setProgressCallback([this, progress](uint64_t cost) {
+        recordBound(cost);
+        if (progress)
+            progress(cost);
+    });
+    S->loadFormula(maxsat_formula);
+    StatusCode code = search(S, timeLimit, timedOut);
+    S->setProgressCallback(nullptr);
+    if (code == _SATISFIABLE_ && gapStatus == _OPTIMUM_)
+        code = _OPTIMUM_;
+    return code;
+}
+
+StatusCode Timetabler::search(MaxSAT *S, double timeLimit, bool &timedOut) {
+    std::mutex lock;
+    std::condition_variable finished;
+    bool done = false;
+    timedOut = false;
+    std::thread watchdog;
+    if (timeLimit > 0)
+        watchdog = std::thread([&]() {
+            std::unique_lock<std::mutex> guard(lock);
+            if (!finished.wait_for(guard, std::chrono::duration<double>(timeLimit), [&]() { return done; })) {
+                timedOut = true;
+                S->interrupt();
+            }
+        });
+
+    StatusCode code;
+    try {
+        code = S->search();
+    } catch (InterruptedException &) {
+        code = S->model.size() > 0 ? _SATISFIABLE_ : _UNKNOWN_;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        done = true;
+    }
+    finished.notify_one();
+    if (watchdog.joinable())
+        watchdog.join();
+    return code;
+}
+
+Solver *Timetabler::buildSATSolver() {
+    Solver *solver = new Solver();
+    for (int i = 0; i < maxsat_formula->nVars(); i++)
+        solver->newVar();
+    for (int i = 0; i < maxsat_formula->nHard(); i++)
+        solver->addClause(maxsat_formula->getHardClause(i).clause);
+    Encoder enc(_INCREMENTAL_NONE_, _CARD_MTOTALIZER_, _AMO_LADDER_, _PB_GTE_);
+    for (int i = 0; i < maxsat_formula->nPB(); i++) {
+        PB *p = maxsat_formula->getPBConstraint(i);
+        PB pb(p->_lits, p->_coeffs, p->_rhs, p->_sign);
+        if (!pb._sign)
+            pb.changeSign();
+        enc.encodePB(solver, pb._lits, pb._coeffs, pb._rhs);
+    }
+    for (int i = 0; i < maxsat_formula->nCard(); i++) {
+        Card *card = maxsat_formula->getCardinalityConstraint(i);
+        if (card->_rhs == 1)
+            enc.encodeAMO(solver, card->_lits);
+        else
+            enc.encodeCardinality(solver, card->_lits, card->_rhs);
+    }
+    return solver;
+}
+
+int Timetabler::enumeratePlans(const vec<lbool> &model, int k, uint64_t maxCost, int distance, double timeLimit,
+                               std::function<void(int, vec<lbool> &, uint64_t)> found) {
+    Solver *solver = buildSATSolver();
+    int vars = maxsat_formula->nVars();
+    vec<int> routes;
+    indexMap::const_iterator it = maxsat_formula->getIndexToName().begin();
+    while (it != maxsat_formula->getIndexToName().end()) {
+        if (it->second.compare(0, 2, "t^") == 0 && it->first < vars)
+            routes.push(it->first);
+        it++;
+    }
+
+    // Cost bound
+    PBObjFunction *of = maxsat_formula->getObjFunction();
+    vec<Lit> lits;
+    vec<uint64_t> coeffs;
+    uint64_t sum = 0;
+    for (int i = 0; of != NULL && i < of->_lits.size(); i++) {
+        if (of->_coeffs[i] > maxCost) {
+            solver->addClause(~of->_lits[i]);
+            continue;
+        }
+        lits.push(of->_lits[i]);
+        coeffs.push(of->_coeffs[i]);
+        sum += of->_coeffs[i];
+    }
+    if (sum > maxCost) {
+        Encoder enc(_INCREMENTAL_NONE_, _CARD_MTOTALIZER_, _AMO_LADDER_, _PB_GTE_);
+        enc.encodePB(solver, lits, coeffs, maxCost);
+    }
+
+    // Stops the SAT solver at the time limit, as the watchdog of 'search'
+    std::mutex lock;
+    std::condition_variable finished;
+    bool done = false, expired = false;
+    std::thread watchdog;
+    if (timeLimit > 0)
+        watchdog = std::thread([&]() {
+            std::unique_lock<std::mutex> guard(lock);
+            if (!finished.wait_for(guard, std::chrono::duration<double>(timeLimit), [&]() { return done; })) {
+                std::lock_guard<std::mutex> active(enumeratingLock);
+                expired = true;
+                if (enumerating != NULL)
+                    enumerating->interrupt();
+            }
+        });
+
+    int n = 0;
+    vec<lbool> plan;
+    model.copyTo(plan);
+    while (n < k) {
+        // At most routes.size() - distance route variables as in 'plan'
+        vec<Lit> same;
+        for (int i = 0; i < routes.size(); i++)
+            same.push(routes[i] < plan.size() && plan[routes[i]] == l_True ? mkLit(routes[i]) : ~mkLit(routes[i]));
+        if (distance <= 1) {
+            vec<Lit> block;
+            for (int i = 0; i < same.size(); i++)
+                block.push(~same[i]);
+            solver->addClause(block);
+        } else if (distance >= same.size()) {
+            for (int i = 0; i < same.size(); i++)
+                solver->addClause(~same[i]);
+        } else {
+            Encoder enc(_INCREMENTAL_NONE_, _CARD_MTOTALIZER_, _AMO_LADDER_, _PB_GTE_);
+            enc.encodeCardinality(solver, same, same.size() - distance);
+        }
+        // Look for a plan close to the last one first
+        for (int i = 0; i < vars && i < plan.size(); i++)
+            solver->setPolarity(i, plan[i] == l_False);
+        {
+            std::lock_guard<std::mutex> guard(enumeratingLock);
+            if (interrupted || expired)
+                break;
+            enumerating = solver;
+        }
+        lbool res = solver->solveLimited(vec<Lit>());
+        {
+            std::lock_guard<std::mutex> guard(enumeratingLock);
+            enumerating = NULL;
+        }
+        if (res != l_True)
+            break;
+        plan.clear();
+        for (int i = 0; i < vars; i++)
+            plan.push(solver->model[i]);
+        found(++n, plan, planCost(plan));
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        done = true;
+    }
+    finished.notify_one();
+    if (watchdog.joinable())
+        watchdog.join();
+    delete solver;
+    return n;
+}
+
+void Timetabler::interrupt() {
+    {
+        std::lock_guard<std::mutex> guard(enumeratingLock);
+        interrupted = true;
+        if (enumerating != NULL)
+            enumerating->interrupt();
+    }
+    if (S != NULL)
+        S->interrupt();
+}
+
+int Timetabler::widenHorizon() {
+    if (horizon == 0 || !delays || option != 2)
+        return 0;
+    Solver *solver = buildSATSolver();
+    PBObjFunction *of = maxsat_formula->getObjFunction(), added;
+    if (of == NULL)
+        of = &added;
+    int count = 0;
+    while (true) {
+        // Horizon literal -> train and requirement of every clipped window
+        std::map<int, std::pair<const Train *, Requirement *> > clipped;
+        vec<Lit> assumptions;
+        for (const Train &train: instance.train)
+            for (Requirement *r: train.t) {
+                std::string name = "h^" + train.id + "^" + r->section_marker;
+                std::vector<char> cname(name.begin(), name.end());
+                cname.push_back('\0');
+                int id = maxsat_formula->varID(&cname[0]);
+                if (id == var_Undef || widened.count(train.id + "^" + r->section_marker) > 0)
+                    continue;
+                clipped[id] = std::make_pair(&train, r);
+                assumptions.push(~mkLit(id));
+            }
+        if (assumptions.size() == 0 || solver->solve(assumptions))
+            break;
+        int hard = maxsat_formula->nHard();
+        int before = count;
+        for (int i = 0; i < solver->conflict.size(); i++) {
+            std::map<int, std::pair<const Train *, Requirement *> >::iterator it = clipped.find(var(solver->conflict[i]));
+            if (it == clipped.end())
+                continue;
+            const Train &train = *it->second.first;
+            Requirement *r = it->second.second;
+            int from = windowEnd(train, r);
+            widened.insert(train.id + "^" + r->section_marker);
+            // The times themselves only appear in a trivial PB constraint
+            // (see 'encodeTimes'), which is left out.
+            encodeDelays(train, r, from, r->sec_exit_latest, of, true);
+            count++;
+        }
+        if (count == before)
+            break;// UNSAT with every window widened
+        while (solver->nVars() < maxsat_formula->nVars())
+            solver->newVar();
+        for (int i = hard; i < maxsat_formula->nHard(); i++)
+            solver->addClause(maxsat_formula->getHardClause(i).clause);
+    }
+    delete solver;
+    if (of == &added && added._lits.size() != 0)
+        maxsat_formula->addObjFunction(&added);
+
+    // Windows still clipped
+    for (const Train &train: instance.train)
+        for (Requirement *r: train.t) {
+            std::string name = "h^" + train.id + "^" + r->section_marker;
+            std::vector<char> cname(name.begin(), name.end());
+            cname.push_back('\0');
+            int id = maxsat_formula->varID(&cname[0]);
+            if (id == var_Undef || windowEnd(train, r) == r->sec_exit_latest)
+                continue;
+            vec<Lit> lit;
+            lit.push(~mkLit(id));
+            maxsat_formula->addHardClause(lit);
+            hardOwner.push_back(train.id);
+        }
+    return count;
+}
+
+void Timetabler::initCheckpoint(const std::string &config) {
+    if (checkpoint.vars > 0)
+        return;
+    checkpoint.hash = encodingHash();
+    checkpoint.vars = maxsat_formula->nVars();
+    checkpoint.config = config;
+    installHooks();
+}
+
+void Timetabler::installHooks() {
+    S->setProgressCallback([this](uint64_t cost) { recordBound(cost); });
+    S->setSolverCallback([this](Solver *solver) { recordSolver(solver); });
+}
+
+lbool Timetabler::diagnose(int64_t propagations, std::vector<std::string> &groups, bool &minimal) {
+    groups.clear();
+    minimal = true;
+    vec<Lit> assumptions;
+    indexMap::const_iterator it = maxsat_formula->getIndexToName().begin();
+    while (it != maxsat_formula->getIndexToName().end()) {
+        if (it->second.compare(0, 2, "a^") == 0)
+            assumptions.push(mkLit(it->first));
+        it++;
+    }
+    Solver *solver = buildSATSolver();
+    if (propagations >= 0)
+        solver->setPropBudget(propagations);
+    lbool res = solver->solveLimited(assumptions);
+    if (res == l_False) {
+        assumptions.clear();
+        for (int i = 0; i < solver->conflict.size(); i++)
+            assumptions.push(~solver->conflict[i]);
+        int64_t left = propagations < 0 ? -1 : std::max<int64_t>(0, propagations - solver->propagations);
+        minimal = groupMUS(solver, assumptions, left);
+        for (int i = 0; i < assumptions.size(); i++)
+            groups.push_back(describeGroup(maxsat_formula->getIndexToName().at(var(assumptions[i]))));
+    }
+    delete solver;
+    return res;
+}
+
+bool Timetabler::groupMUS(Solver *solver, vec<Lit> &assumptions, int64_t propagations) {
+    uint64_t start = solver->propagations;
+    bool minimal = true;
+    vec<Lit> critical, candidates, assumps;
+    assumptions.copyTo(candidates);
+    while (candidates.size() > 0) {
+        int64_t used = solver->propagations - start;
+        if (propagations >= 0 && used >= propagations) {
+            // Out of budget: keep what was not tried.
+            for (int i = 0; i < candidates.size(); i++)
+                critical.push(candidates[i]);
+            minimal = false;
+            break;
+        }
+        Lit test = candidates.last();
+        candidates.pop();
+        critical.copyTo(assumps);
+        for (int i = 0; i < candidates.size(); i++)
+            assumps.push(candidates[i]);
+        if (propagations >= 0)
+            solver->setPropBudget(propagations - used);
+        lbool res = solver->solveLimited(assumps);
+        if (res == l_False) {
+            // 'test' is not needed, nor any candidate outside the conflict.
+            std::set<int> failed;
+            for (int i = 0; i < solver->conflict.size(); i++)
+                failed.insert(toInt(~solver->conflict[i]));
+            int j = 0;
+            for (int i = 0; i < candidates.size(); i++)
+                if (failed.count(toInt(candidates[i])) > 0)
+                    candidates[j++] = candidates[i];
+            candidates.shrink(candidates.size() - j);
+        } else {
+            critical.push(test);
+            if (res == l_Undef)
+                minimal = false;
+        }
+    }
+    solver->budgetOff();
+    critical.copyTo(assumptions);
+    return minimal;
+}
+
+// Implied clauses have no train: the next 'reoptimise' drops them, like the
+// units of the blocked resources.
+void Timetabler::addImpliedClause(vec<Lit> &clause) {
+    maxsat_formula->addHardClause(clause);
+    hardOwner.push_back("");
+}
+
+int Timetabler::useClauseCache(ClauseCache *cache) {
+    int injected = cache->inject(*this);
+    clauseCache = cache;
+    installHooks();
+    return injected;
+}
+
+void Timetabler::enableCheckpoints(const std::string &file, double interval, const std::string &config) {
+    initCheckpoint(config);
+    checkpointFile = file;
+    checkpointInterval = interval;
+    lastCheckpoint = std::chrono::steady_clock::now();
+    installHooks();
+}
+
+void Timetabler::useBroker(BrokerClient *client) {
+    broker = client;
+    nextSync = client->syncInterval();
+    installHooks();
+}
+
+void Timetabler::stopAtGap(double gap) {
+    this->gap = gap;
+    installHooks();
+}
+
+bool Timetabler::resume(const std::string &file, const std::string &config, std::string &error) {
+    Checkpoint saved;
+    if (!saved.load(file, error))
+        return false;
+    initCheckpoint(config);
+    if (saved.hash != checkpoint.hash || saved.vars != checkpoint.vars) {
+        error = file + " is a checkpoint of another instance or encoding";
+        return false;
+    }
+
+    for (const std::vector<int> &learnt: saved.learnts) {
+        vec<Lit> clause;
+        for (int lit: learnt)
+            clause.push(mkLit(abs(lit) - 1, lit < 0));
+        addImpliedClause(clause);
+    }
+    checkpoint.learnts.swap(saved.learnts);
+    resumedLearnts = checkpoint.learnts.size();
+
+    checkpoint.lb = saved.lb;
+    if (!saved.model.empty()) {
+        checkpoint.model.swap(saved.model);
+        checkpoint.ub = saved.ub;
+        vec<lbool> start;
+        for (bool value: checkpoint.model)
+            start.push(value ? l_True : l_False);
+        S->setWarmStart(start, checkpoint.ub);
+    }
+    checkpoint.optimum = saved.optimum || (!checkpoint.model.empty() && checkpoint.lb >= checkpoint.ub);
+    if (saved.config == checkpoint.config) {
+        checkpoint.phase = saved.phase;
+        S->setResumePhase(saved.phase);
+    }
+    return true;
+}
+
+void Timetabler::recordBound(uint64_t cost) {
+    if (cost < searchCost)
+        searchCost = cost;
+    checkGap();
+    if (broker != NULL)
+        broker->sendBound(cost, S->model);
+    if (checkpoint.vars == 0 || cost >= checkpoint.ub || S->model.size() < checkpoint.vars)
+        return;
+    checkpoint.ub = cost;
+    checkpoint.model.resize(checkpoint.vars);
+    for (int i = 0; i < checkpoint.vars; i++)
+        checkpoint.model[i] = S->model[i] == l_True;
+}
+
+// Called after every SAT call of 'S'.
+void Timetabler::recordSolver(Solver *solver) {
+    checkGap();
+    if (broker != NULL) {
+        uint64_t lb = bestLowerBound();
+        if (lb > sentLB) {
+            broker->sendLowerBound(lb);
+            sentLB = lb;
+        }
+        // A deterministic portfolio only sends incumbents at synchronisation
+        // points.
+        uint64_t interval = broker->syncInterval();
+        if (interval > 0 && S->satConflicts() >= nextSync) {
+            nextSync = (S->satConflicts() / interval + 1) * interval;
+            broker->sync();
+        }
+        uint64_t cost;
+        vec<lbool> model;
+        if (broker->poll(cost, model) && cost < searchCost)
+            S->setWarmStart(model, cost);
+    }
+    if (clauseCache != NULL && S->learntsAreImplied())
+        clauseCache->collect(*this, solver);
+    if (checkpointFile.empty())
+        return;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - lastCheckpoint).count() < checkpointInterval)
+        return;
+    if (S->learntsAreImplied()) {
+        vec<vec<Lit> > learnts;
+        solver->learntClauses(learnts, checkpoint.vars, Checkpoint::maxLBD,
+                              Checkpoint::maxLearnts - resumedLearnts);
+        checkpoint.learnts.resize(resumedLearnts);
+        for (int i = 0; i < learnts.size(); i++) {
+            std::vector<int> clause;
+            for (int j = 0; j < learnts[i].size(); j++)
+                clause.push_back(sign(learnts[i][j]) ? -(var(learnts[i][j]) + 1) : var(learnts[i][j]) + 1);
+            checkpoint.learnts.push_back(clause);
+        }
+    }
+    std::string error;
+    if (!saveCheckpoint(false, error))
+        printf("c Warning: %s\n", error.c_str());
+}
+
+bool Timetabler::saveCheckpoint(bool optimum, std::string &error) {
+    if (checkpointFile.empty())
+        return true;
+    lastCheckpoint = std::chrono::steady_clock::now();
+    checkpoint.phase = S->getPhase();
+    checkpoint.lb = std::max(checkpoint.lb, bestLowerBound());
+    if (optimum && !checkpoint.model.empty()) {
+        checkpoint.optimum = true;
+        checkpoint.lb = checkpoint.ub;
+    }
+    return checkpoint.save(checkpointFile, error);
+}
+
+uint64_t Timetabler::bestLowerBound() {
+    return std::max(lowerBound, S->getLowerBound());
+}
+
+// Interrupts 'S' when its best cost is close enough to the lower bound.
+void Timetabler::checkGap() {
+    if (gap < 0 || searchCost == UINT64_MAX || gapStatus != _UNKNOWN_)
+        return;
+    uint64_t lb = bestLowerBound();
+    if (searchCost > lb && searchCost - lb > gap * searchCost)
+        return;
+    gapStatus = searchCost <= lb ? _OPTIMUM_ : _SATISFIABLE_;
+    S->interrupt();
+}
+
+bool Timetabler::bestModel() {
+    if (!checkpoint.model.empty() && checkpoint.ub < searchCost) {
+        S->model.clear();
+        for (bool value: checkpoint.model)
+            S->model.push(value ? l_True : l_False);
+    }
+    return S->model.size() > 0;
+}
+
+static std::vector<Train>::iterator findTrain(Instance &instance, const std::string &id) {
+    std::vector<Train>::iterator t = instance.train.begin();
+    while (t != instance.train.end() && t->id != id)
+        t++;
+    return t;
+}
+
+static Requirement *findRequirement(Instance &instance, const std::string &train, const std::string &id) {
+    std::vector<Train>::iterator t = findTrain(instance, train);
+    if (t != instance.train.end())
+        for (Requirement *r: t->t)
+            if (r->id == id)
+                return r;
+    return NULL;
+}
+
+// Returns a requirement of 'train' that may be modified: the caller's
+// requirements are copied first.
+Requirement *Timetabler::writableRequirement(Train &train, Requirement *r) {
+    if (ownsInstance || std::find(ownedRequirements.begin(), ownedRequirements.end(), r) != ownedRequirements.end())
+        return r;
+    Requirement *copy = new Requirement(*r);
+    ownedRequirements.push_back(copy);
+    std::replace(train.t.begin(), train.t.end(), r, copy);
+    return copy;
+}
+
+// Adds the resources of the sections 'train' runs on in 'plan'.
+void Timetabler::usedResources(const std::string &train, const vec<lbool> &plan,
+                               std::set<std::string> &resources) {
+    std::map<int,route_section*>::iterator it = instance.sectionMap[train].begin();
+    while (it != instance.sectionMap[train].end()) {
+        int v = getVariableID("t^" + train + "^" + std::to_string(it->first));
+        if (v < plan.size() && plan[v] == l_True)
+            for (const Resource &res: it->second->resource_occupations)
+                resources.insert(res.getId());
+        it++;
+    }
+}
+
+StatusCode Timetabler::reoptimise(const Delta &delta,
+                                  std::function<MaxSAT *(MaxSATFormula *)> newAlgorithm,
+                                  uint64_t perturbationWeight, double timeLimit,
+                                  std::function<void(uint64_t)> progress) {
+    if (S == NULL || S->model.size() == 0)
+        throw std::runtime_error("No plan to re-optimise");
+
+    vec<lbool> plan;
+    S->model.copyTo(plan);
+    std::set<std::string> freed, removed, retimed;
+    std::set<std::string> resources(delta.blockedResources.begin(), delta.blockedResources.end());
+
+    // Check the delta before changing anything.
+    for (const Delta::Window &w: delta.windows)
+        if (findRequirement(instance, w.train, w.requirement) == NULL)
+            throw std::runtime_error("Unknown requirement " + w.requirement + " of train " + w.train);
+    for (const std::string &id: delta.removedTrains)
+        if (findTrain(instance, id) == instance.train.end())
+            throw std::runtime_error("Unknown train " + id);
+    for (const Train &train: delta.addedTrains)
+        if (instance.sectionMap.find(train.route) == instance.sectionMap.end())
+            throw std::runtime_error("Unknown route " + train.route);
+
+    // Apply it to the instance.
+    for (const Delta::Window &w: delta.windows) {
+        std::vector<Train>::iterator t = findTrain(instance, w.train);
+        Requirement *r = findRequirement(instance, w.train, w.requirement);
+        r = writableRequirement(*t, r);
+        if (w.entryEarliest != -1)
+            r->sec_entry_earliest = w.entryEarliest;
+        if (w.entryLatest != -1)
+            r->sec_entry_latest = w.entryLatest;
+        if (w.exitEarliest != -1)
+            r->sec_exit_earliest = w.exitEarliest;
+        if (w.exitLatest != -1)
+            r->sec_exit_latest = w.exitLatest;
+        freed.insert(w.train);
+        retimed.insert(w.train);
+        usedResources(w.train, plan, resources);
+    }
+    for (const std::string &id: delta.removedTrains) {
+        std::vector<Train>::iterator t = findTrain(instance, id);
+        if (t == instance.train.end())
+            continue;// listed twice
+        usedResources(id, plan, resources);
+        if (ownsInstance)
+            for (Requirement *r: t->t)
+                delete r;
+        instance.train.erase(t);
+        removed.insert(id);
+        freed.erase(id);
+    }
+    std::vector<Train> added;
+    for (const Train &train: delta.addedTrains) {
+        Train copy = train;
+        for (Requirement *&r: copy.t) {
+            r = new Requirement(*r);
+            if (!ownsInstance)
+                ownedRequirements.push_back(r);
+        }
+        instance.train.push_back(copy);
+        added.push_back(copy);
+        freed.insert(copy.id);
+        removed.erase(copy.id);
+        std::map<int,route_section*>::iterator it = instance.sectionMap[copy.route].begin();
+        while (it != instance.sectionMap[copy.route].end()) {
+            for (const Resource &res: it->second->resource_occupations)
+                resources.insert(res.getId());
+            it++;
+        }
+    }
+
+    // Free the trains sharing a resource with the change, then the trains
+    // connected to a freed one.
+    for (const Train &train: instance.train) {
+        std::set<std::string> used;
+        usedResources(train.id, plan, used);
+        for (const std::string &res: used)
+            if (resources.count(res) > 0)
+                freed.insert(train.id);
+    }
+    std::set<std::string> connected;
+    for (const Train &train: instance.train)
+        for (Requirement *r: train.t)
+            for (const connection &c: r->connections) {
+                std::string onto = std::to_string(c.id);
+                if (freed.count(train.id) > 0)
+                    connected.insert(onto);
+                else if (freed.count(onto) > 0)
+                    connected.insert(train.id);
+            }
+    for (const std::string &id: connected)
+        if (removed.count(id) == 0)
+            freed.insert(id);
+    freedTrains = freed.size();
+
+    // Carry over the encoding of the unchanged trains. Variables keep their
+    // identifiers, so that 'plan' still applies.
+    MaxSATFormula *previous = maxsat_formula;
+    maxsat_formula = new MaxSATFormula();
+    maxsat_formula->setFormat(_FORMAT_PB_);
+    copyVariables(previous, previous->nInitialVars(), maxsat_formula);
+    // The templates refer to variables of the previous formula
+    routeTemplates.clear();
+    slotVars.clear();
+    // Changed and added trains are encoded again, and the units excluding
+    // blocked sections are generated again from 'blocked'.
+    std::set<std::string> dropped(removed);
+    dropped.insert(retimed.begin(), retimed.end());
+    for (const Train &train: added)
+        dropped.insert(train.id);
+    dropped.insert("");
+    std::vector<std::string> owners;
+    owners.swap(hardOwner);
+    for (size_t i = 0; i < owners.size(); i++)
+        if (dropped.count(owners[i]) == 0) {
+            maxsat_formula->addHardClause(previous->getHardClause(i).clause);
+            hardOwner.push_back(owners[i]);
+        }
+    owners.clear();
+    owners.swap(cardOwner);
+    for (size_t i = 0; i < owners.size(); i++)
+        if (dropped.count(owners[i]) == 0) {
+            Card *card = previous->getCardinalityConstraint(i);
+            vec<uint64_t> coeffs(card->_lits.size(), 1);
+            addPBConstraint(new PB(card->_lits, coeffs, card->_rhs, true), owners[i]);
+        }
+    owners.clear();
+    owners.swap(pbOwner);
+    for (size_t i = 0; i < owners.size(); i++)
+        if (dropped.count(owners[i]) == 0) {
+            PB *pb = previous->getPBConstraint(i);
+            addPBConstraint(new PB(pb->_lits, pb->_coeffs, pb->_rhs, pb->_sign), owners[i]);
+        }
+    for (const Train &train: instance.train)
+        if (dropped.count(train.id) > 0) {
+            encodeMusts(train);
+            encodeTimes(train);
+            if (activations)
+                encodeActivations(train);
+        }
+    blocked.insert(delta.blockedResources.begin(), delta.blockedResources.end());
+    for (const Train &train: instance.train) {
+        std::map<int,route_section*>::iterator it = instance.sectionMap[train.route].begin();
+        while (it != instance.sectionMap[train.route].end()) {
+            for (const Resource &res: it->second->resource_occupations)
+                if (blocked.count(res.getId()) > 0) {
+                    vec<Lit> lit;
+                    lit.push(~mkLit(getVariableID("t^" + train.id + "^" + std::to_string(it->first))));
+                    maxsat_formula->addHardClause(lit);
+                    hardOwner.push_back("");
+                    break;
+                }
+            it++;
+        }
+    }
+
+    // Minimal perturbation: fixed trains keep their sections, freed trains
+    // pay their route penalties and every section changed from 'plan'.
+    // Sections of routes without a train are not used.
+    std::set<std::string> live;
+    for (const Train &train: instance.train)
+        live.insert(train.id);
+    vec<Lit> fixed;
+    PBObjFunction of;
+    std::map<std::string,std::map<int,route_section*>>::iterator route = instance.sectionMap.begin();
+    while (route != instance.sectionMap.end()) {
+        std::map<int,route_section*>::iterator it = route->second.begin();
+        while (it != route->second.end()) {
+            std::string section = route->first + "^" + std::to_string(it->first);
+            Lit l = mkLit(getVariableID("t^" + section));
+            bool known = var(l) < plan.size() && plan[var(l)] != l_Undef;
+            if (live.count(route->first) == 0)
+                fixed.push(~l);
+            else if (freed.count(route->first) == 0) {
+                if (known)
+                    fixed.push(plan[var(l)] == l_True ? l : ~l);
+            } else {
+                std::map<std::string, double>::iterator pen = instance.route_pen.find(section);
+                if (pen != instance.route_pen.end() && ceil(pen->second) > 0)
+                    of.addProduct(l, ceil(pen->second));
+                if (known && perturbationWeight > 0)
+                    of.addProduct(plan[var(l)] == l_True ? ~l : l, perturbationWeight);
+            }
+            it++;
+        }
+        route++;
+    }
+    // Delays of the freed trains, and order literals of the re-encoded ones
+    if (delays && option == 2)
+        for (const Train &train: instance.train)
+            if (dropped.count(train.id) > 0 || freed.count(train.id) > 0)
+                encodeDelays(train, freed.count(train.id) > 0 ? &of : NULL, dropped.count(train.id) > 0);
+    bool objective = of._lits.size() != 0;
+    if (objective)
+        maxsat_formula->addObjFunction(&of);
+
+    if (S->getMaxSATFormula() != previous)
+        delete previous;
+    delete S;
+    S = newAlgorithm(maxsat_formula);
+    if (S == NULL)
+        throw std::runtime_error("Invalid MaxSAT algorithm");
+    S->setFixedAssumptions(fixed);
+    // Bounds of the previous objective
+    lowerBound = 0;
+    searchCost = UINT64_MAX;
+    gapStatus = _UNKNOWN_;
+    StatusCode code = solve(timeLimit, progress);
+    // Nothing was freed: the current plan is still the best one.
+    if (code == _SATISFIABLE_ && !objective && !timedOut)
+        code = _OPTIMUM_;
+    return code;
+}
+#endif
+
+#endif
@@ -0,0 +1,403 @@
+//
+// Per-request state of the timetabler.
+//
+
+#ifndef TRAIN_SCHEDULE_OPTIMISATION_TIMETABLER_H
+#define TRAIN_SCHEDULE_OPTIMISATION_TIMETABLER_H
+
+#include <stdexcept>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// Malformed instances must not abort a long running process (see Server.h):
+// turn the parser's assertions into exceptions. Include this header before
+// any rapidjson header so that every translation unit agrees on the macro.
+#ifndef RAPIDJSON_ASSERT
+#define RAPIDJSON_ASSERT(x) \
+    ((x) ? (void) 0 : throw std::runtime_error("Invalid instance: " #x))
+#endif
+#include "../rapidjson/document.h"
+
+#include "../problem/Instance.h"
+#include "../problem/Periodic.h"
+#include "Checkpoint.h"
+
+#if MAXSATNID==1
+#include "../solver/TT-Open-WBO-Inc/MaxSAT.h"
+#elif MAXSATNID==2
+#include "../solver/Loandra/MaxSAT.h"
+#elif MAXSATNID==3
+#include "../solver/Open-WBO-Inc/MaxSAT.h"
+#elif MAXSATNID==4
+#include "../solver/LinSBPS/MaxSAT.h"
+#endif
+
+class BrokerClient;
+class ClauseCache;
+
+// Changes to a solved instance, see 'Timetabler::reoptimise'.
+struct Delta {
+    // New window of a section requirement in seconds, -1 keeps the bound.
+    struct Window {
+        std::string train;          // service intention id
+        std::string requirement;    // Requirement::id
+        int entryEarliest = -1, entryLatest = -1;
+        int exitEarliest = -1, exitLatest = -1;
+    };
+    std::vector<Window> windows;
+    std::vector<std::string> removedTrains;
+    // Trains on routes of the instance (the encoding expects the route id to
+    // be the train id). Their requirements are copied.
+    std::vector<Train> addedTrains;
+    std::vector<std::string> blockedResources;  // Resource ids
+};
+
+// State of a single timetabling request: the instance, its encoding and the
+// MaxSAT solver working on it. Nothing is shared between two objects, so
+// each request (command line run, server request, ...) gets its own.
+class Timetabler {
+public:
+    Timetabler();
+    ~Timetabler();
+
+    bool readJSONFile(const char *local);
+    bool readJSON(const char *buffer, size_t length);
+    // Uses an instance built in memory. Its sections and requirements stay
+    // owned by the caller and must outlive this object.
+    void setInstance(const Instance &instance);
+    // Reads a PESP instance in the PESPlib activity format: one activity
+    // per line, "<id>; <from>; <to>; <lower>; <upper>; <weight>" (';', ','
+    // or blanks), with '#' starting a comment. A line mentioning "period"
+    // (e.g. "# period 60" or "period_length; 60") sets the period, which
+    // is 'period' otherwise.
+    bool readPESPFile(const char *local, int period, std::string &error);
+
+    // Serialises 'instance.results' in the output format of the challenge.
+    void writeJSON(std::string &out);
+    // Writes data/<label>.out.json, or data/<label>.<variant>.out.json.
+    void outputJSONFile(const std::string &variant = "");
+
+    Instance instance;
+    PeriodicInstance periodic;// see 'readPESPFile'
+    int minV, maxV, diffV;
+    int size;
+
+#if MAXSATNID<5
+    void genEncoding();
+    // Encodes 'periodic' instead of 'instance'. The time of every event is
+    // order encoded over a single period, p^<event>^<k> meaning "at k or
+    // later" for k in [1, period). A value of the time of the source of an
+    // activity forbids an interval of times of its target (two, if it
+    // wraps around the period), so each activity costs O(period) clauses
+    // of at most four literals. The objective counts the tension above the
+    // lower bound of every activity with order literals w^<activity>^<t>
+    // ("tension at least lower + t"), of cost 'weight' each.
+    void genPESPEncoding();
+    // Fills 'periodic.times' from 'model' and writes them to
+    // data/<label>.timetable, as "<event>; <time>" lines. Returns the
+    // weighted tension of the timetable.
+    uint64_t outputPESPFile(const vec<lbool> &model);
+    // Fills 'instance.results' with the sections selected by 'model'.
+    void decodeModel(vec<lbool> &model);
+    // Get the variable identifier corresponding to a given name. If the
+    // variable does not exist, a new identifier is created.
+    int getVariableID(const std::string &varName);
+    // Returns a copy of the encoding, to be loaded by another algorithm.
+    // Only reads 'maxsat_formula', so concurrent calls are safe.
+    openwbo::MaxSATFormula *copyEncoding();
+    // Hash of the variables, constraints and objective of the encoding.
+    uint64_t encodingHash();
+    // Objective value of 'model': the route penalties of its sections, its
+    // delays (see 'delays') and its violated requirements in relaxation
+    // mode, or the weighted tension above the lower bounds of a PESP
+    // instance.
+    uint64_t planCost(const vec<lbool> &model);
+    // Lower bound on the objective of the encoding, computed before the
+    // search: the sum of the weights of disjoint cores, first from the
+    // section requirements of each train (a requirement whose sections are
+    // all penalised costs at least its cheapest one), then, with
+    // TT-Open-WBO-Inc, from SAT calls on the hard clauses assuming every
+    // other objective literal false, for at most 'probeConflicts'
+    // conflicts in all (0 for none). With 'activations' a requirement may
+    // be switched off, so only the SAT calls count, and their cores also
+    // span the activation literals of the objective.
+    uint64_t computeLowerBound(int64_t probeConflicts);
+    uint64_t lowerBound;// by the last 'computeLowerBound', 0 before
+
+#if MAXSATNID==1
+    // Loads the encoding into 'S' and searches for at most 'timeLimit'
+    // seconds of wall-clock time (0 for no limit). 'progress' is called with
+    // each new upper bound, when 'S->model' holds the corresponding model.
+    StatusCode solve(double timeLimit, std::function<void(uint64_t)> progress);
+    bool timedOut;
+    // Runs 'S->search()' for at most 'timeLimit' seconds (0 for no limit).
+    static StatusCode search(openwbo::MaxSAT *S, double timeLimit, bool &timedOut);
+    // SAT solver with the hard part of the encoding, as in the algorithms'
+    // 'rebuildSolver'. Owned by the caller.
+    Solver *buildSATSolver();
+
+    // Applies 'delta' to a solved request and searches for a new plan close
+    // to the current one. Only the trains touched by the delta are freed:
+    // changed and added trains, trains of the current plan sharing a resource
+    // with a changed, removed or blocked one, and trains connected to a freed
+    // one. The sections of every other train are fixed by assumptions. The
+    // objective is the route penalty of the freed trains plus
+    // 'perturbationWeight' per section that differs from the current plan.
+    // The variables, clauses and constraints of unchanged trains are carried
+    // over from the current encoding, and 'newAlgorithm' builds the search.
+    // The new plan is the reference of the next call.
+    StatusCode reoptimise(const Delta &delta,
+                          std::function<openwbo::MaxSAT *(openwbo::MaxSATFormula *)> newAlgorithm,
+                          uint64_t perturbationWeight, double timeLimit,
+                          std::function<void(uint64_t)> progress);
+    int freedTrains;// by the last 'reoptimise'
+
+    // Saves the state of the search of 'S' to 'file' (see Checkpoint.h) at
+    // most every 'interval' seconds, and on 'saveCheckpoint'. 'config' names
+    // the algorithm and its options: only the same configuration resumes
+    // the phase of the search. Call before loading the encoding into 'S'.
+    void enableCheckpoints(const std::string &file, double interval, const std::string &config);
+    // Resumes from the checkpoint 'file' of the same encoding: its learnt
+    // clauses are added to the encoding, its model is the warm start of 'S'
+    // and 'S' starts from its phase. Call before loading the encoding into
+    // 'S'. Returns false if the checkpoint cannot be used.
+    bool resume(const std::string &file, const std::string &config, std::string &error);
+    // Does nothing unless checkpoints are enabled.
+    bool saveCheckpoint(bool optimum, std::string &error);
+    // Copies the best model known into 'S->model' (that of 'S' or the one
+    // restored by 'resume'), returning false if there is none.
+    bool bestModel();
+    Checkpoint checkpoint;// best state known, saved by 'saveCheckpoint'
+
+    // Adds to the encoding the clauses of 'cache' it implies, and collects
+    // the cores and learnt clauses of the search of 'S' into 'cache' (see
+    // ClauseCache.h). Call after 'resume' and 'enableCheckpoints', before
+    // loading the encoding into 'S'. Returns the number of added clauses.
+    int useClauseCache(ClauseCache *cache);
+    // Checks the hard part of the encoding with every group active (see
+    // 'activations') and, if it is UNSAT, explains why: 'groups' is set to
+    // a group MUS of the activation variables (see 'groupMUS'), computed
+    // within 'propagations' propagations (-1 for no limit). 'minimal' is
+    // false if the budget ran out first. Returns l_Undef if the check
+    // itself ran out of budget.
+    lbool diagnose(int64_t propagations, std::vector<std::string> &groups, bool &minimal);
+    // Reduces 'assumptions', an UNSAT set of assumptions of 'solver', to a
+    // minimal UNSAT subset by trying to drop them one by one, keeping only
+    // those in the conflict of every UNSAT call (as the Muser of MaxHS).
+    // Stops within 'propagations' propagations of 'solver' (-1 for no
+    // limit), keeping the assumptions not tried yet: returns false if the
+    // result may not be minimal.
+    static bool groupMUS(Solver *solver, vec<Lit> &assumptions, int64_t propagations);
+    // Enumerates up to 'k' plans other than 'model' in one incremental SAT
+    // solver with the hard part of the encoding, each of cost at most
+    // 'maxCost' (a PB constraint on the objective) and differing from
+    // 'model' and every plan found before in at least 'distance' route
+    // section variables t^<route>^<sequence number> (a blocking clause
+    // for 1, a cardinality constraint otherwise). 'found' is called with
+    // the index of each plan from 1, the plan and its cost. Stops after
+    // 'timeLimit' seconds of wall-clock time (0 for no limit) or on
+    // 'interrupt'. Returns the number of plans found: fewer than 'k' if
+    // there are no more or the search was stopped.
+    int enumeratePlans(const vec<lbool> &model, int k, uint64_t maxCost, int distance, double timeLimit,
+                       std::function<void(int, vec<lbool> &, uint64_t)> found);
+    // Stops the search of 'S' and the SAT solver of 'enumeratePlans'. Safe
+    // to call from another thread.
+    void interrupt();
+    // Checks the hard part of the encoding with the windows of 'horizon',
+    // and while it is UNSAT widens the windows whose horizon literals are
+    // in the conflict to the latest exit of their requirement, adding
+    // their times to the encoding and to the same incremental SAT solver.
+    // The windows still clipped are then fixed by hard clauses. Call before
+    // loading the encoding into 'S'. Returns the number of widened windows.
+    int widenHorizon();
+    // Adds a clause that follows from the hard part of the encoding.
+    void addImpliedClause(vec<Lit> &clause);
+    // Sends the incumbents and lower bounds of 'S' to the broker of a
+    // portfolio, and uses the incumbents of the other workers as the warm
+    // start of 'S' (see Portfolio.h). In a deterministic portfolio, 'S'
+    // waits for the other workers at every synchronisation point.
+    void useBroker(BrokerClient *client);
+    // Stops the search of 'S' once its best cost is within 'gap' (a
+    // fraction of the cost) of the best lower bound known, 'lowerBound' or
+    // that of the algorithm. With 0 it stops when the cost meets the bound,
+    // which proves it optimal.
+    void stopAtGap(double gap);
+    // _OPTIMUM_ or _SATISFIABLE_ once the search stopped at the gap,
+    // _UNKNOWN_ before.
+    StatusCode gapStatus;
+#endif
+
+    int option;//-opt-time
+    // Guard every train, requirement and resource with an activation
+    // variable (a^train^<id>, a^requirement^<train>^<id>, a^resource^<id>),
+    // so that they can be switched off by assumptions (see Scenarios.h).
+    bool activations;
+    // Relaxation mode, for instances that are infeasible as specified: every
+    // section requirement may be violated (switched off by its activation
+    // variable, see 'activations') at the cost of its entry delay weight (1
+    // if none) times more than all the route penalties, so the search first
+    // finds the cheapest requirements to violate, then the best plan with
+    // the others. Cancelling a train costs all its requirements. Implies
+    // 'activations'.
+    bool relax;
+    // Delay objective (-delays, with -opt-time=2): every section
+    // requirement with an entry delay weight and a latest entry costs that
+    // weight per started minute of entry after its latest entry. The cost
+    // is carried by the order literals of the timing model (see
+    // 'entryLit') at every minute after the latest entry, so a delay costs
+    // one objective literal per minute rather than per second.
+    // Delays come from the timing model of -delays: every active
+    // requirement is entered at one of its times, and the next requirement
+    // of the train at least its 'minimumStay' later. Connections between
+    // trains and the occupation of resources are not timed.
+    bool delays;
+    static const int delayStep = 60;// seconds between two order literals
+    // Adaptive horizon (with 'delays' and -opt-time=2), in seconds, 0 for
+    // none: the entry time variables of each requirement first end
+    // 'horizon' seconds after its latest entry (its earliest entry if
+    // none) instead of at its latest exit. The rest of a window is left to
+    // its horizon literal h^<train>^<marker> in the entry clause, which
+    // 'widenHorizon' assumes false. Without the timing model of 'delays'
+    // no window could be too short, so the horizon is ignored.
+    int horizon;
+    // Threads encoding the trains in 'genEncoding', 0 for one per core.
+    // The encoding does not depend on it.
+    int encodeThreads;
+    // Groups switched off by 'model', e.g. "requirement 1 of train 111".
+    std::vector<std::string> relaxedGroups(const vec<lbool> &model);
+    // "a^requirement^111^1" -> "requirement 1 of train 111 (section marker
+    // A)", "a^train^111" -> "train 111", "a^resource^R1" -> "resource R1".
+    std::string describeGroup(const std::string &activation);
+    openwbo::MaxSATFormula *maxsat_formula;
+    // Owns 'maxsat_formula' once loaded.
+    openwbo::MaxSAT *S;
+#endif
+
+private:
+    bool ownsInstance;
+    // Requirements created by 'reoptimise' in an instance owned by the caller.
+    std::vector<Requirement *> ownedRequirements;
+    Instance parseInstance(rapidjson::Document &d);
+    void clearResults();
+
+#if MAXSATNID<5
+    // Clauses of 'encodeMusts' and 'encodeActivations' that only depend on
+    // a route, built once per route and instantiated for every train of the
+    // route by mapping its slots to the variables t^<train>^<sequence
+    // number>. Literals of the clauses are over slots: variable s <
+    // sequence.size() is section slot s, variable sequence.size() the
+    // activation of the train and variable sequence.size() + 1 + v the
+    // shared variable shared[v] (a^resource^<id>). The slots of the section
+    // markers come first: they are the only ones 'encodeMusts' uses.
+    struct RouteTemplate {
+        std::vector<int> sequence;// sequence numbers of the slots
+        int markerSlots = 0;
+        std::map<std::string, std::vector<int>> markers;// section marker -> slots
+        std::vector<std::string> shared;
+        std::vector<std::vector<Lit>> activations;
+    };
+    std::map<std::string, RouteTemplate> routeTemplates;
+    // Variables of the template of a train: the slots its clauses use (see
+    // 'slotLit') are the block [base, base + slots), the activation and
+    // shared variables are looked up on first use (var_Undef before). A
+    // block whose variables were created apart, e.g. by 'reoptimise',
+    // lists them in 'vars' instead.
+    struct SlotBlock {
+        int base = var_Undef;
+        std::vector<int> vars;
+        std::vector<int> extra;
+    };
+    typedef std::map<std::string, SlotBlock> SlotVars;// by train
+    SlotVars slotVars;
+    // Constraints of one train, encoded by a worker of 'genEncoding' over
+    // the variables of 'formula' and then merged into 'maxsat_formula', in
+    // the order of the trains.
+    struct TrainEncoding {
+        openwbo::MaxSATFormula formula;
+        std::vector<std::string> hardOwner, cardOwner, pbOwner;
+        openwbo::PBObjFunction objective;// delays
+        SlotVars slotVars;
+        int timeVars = 0;
+    };
+    // Encoding the calling thread writes to, NULL for 'maxsat_formula'.
+    static thread_local TrainEncoding *trainEncoding;
+    openwbo::MaxSATFormula *target() {
+        return trainEncoding != NULL ? &trainEncoding->formula : maxsat_formula;
+    }
+    void addHardClause(vec<Lit> &lit, const std::string &train);
+    void encodeTrain(const Train &train);
+    // Adds the constraints of 'encoding' to 'maxsat_formula' and its delay
+    // costs to 'of'.
+    void mergeEncoding(TrainEncoding &encoding, openwbo::PBObjFunction *of);
+    RouteTemplate &routeTemplate(const std::string &route);
+    Lit slotLit(const Train &train, Lit lit);
+    void encodeMusts(const Train &train);
+    void encodeActivations(const Train &train);
+    void encodeRelaxation(openwbo::PBObjFunction *of);
+    // Adds the delay costs of the train to 'of' (unless NULL) and, with
+    // 'clauses', the clauses of its order literals.
+    void encodeDelays(const Train &train, openwbo::PBObjFunction *of, bool clauses = true);
+    // The same for the entry times [from, to) of 'r'.
+    void encodeDelays(const Train &train, Requirement *r, int from, int to, openwbo::PBObjFunction *of,
+                      bool clauses);
+    // End of the entry time variables of 'r', see 'horizon'.
+    int windowEnd(const Train &train, const Requirement *r);
+    // e^<train>^<marker>^<t>: 'r' entered at or after 't', for entry earliest
+    // < t <= exit latest, and t = entry earliest if the latest entry is
+    // before it.
+    Lit entryLit(const Train &train, const Requirement *r, int t);
+    static int seconds(const std::string &duration);
+    // Minimum stopping time of 'r' plus the minimum running time of its
+    // shortest section: the least time between its entry and the entry of
+    // the next requirement of the train.
+    int minimumStay(const Train &train, const Requirement *r);
+    std::set<std::string> widened;// <train>^<marker> of the widened windows
+    int encodeTimes(const Train &train);
+    // Adds the clause 'clause' OR (time of 'event' not in [from, from +
+    // length] mod period), for 0 <= length < period.
+    void addPeriodicClause(const vec<Lit> &clause, int event, int from, int length);
+    // p^<event>^<k>, undefined outside [1, period).
+    Lit periodicLit(int event, int k);
+    std::vector<std::vector<int> > periodicVars;// [event][k - 1]
+    void addPBConstraint(openwbo::PB *p, const std::string &train);
+    // Weight of disjoint cores of the section requirements of every train.
+    // The variables of the cores are added to 'cores'.
+    uint64_t domainLowerBound(std::set<int> &cores);
+    // Train of every hard clause, cardinality and PB constraint of the
+    // encoding.
+    std::vector<std::string> hardOwner, cardOwner, pbOwner;
+#endif
+#if MAXSATNID==1
+    std::set<std::string> blocked;// resources blocked by 'reoptimise'
+    Requirement *writableRequirement(Train &train, Requirement *r);
+    void usedResources(const std::string &train, const vec<lbool> &plan,
+                       std::set<std::string> &resources);
+
+    std::string checkpointFile;
+    double checkpointInterval;
+    std::chrono::steady_clock::time_point lastCheckpoint;
+    uint64_t searchCost;// best cost found by 'S', UINT64_MAX if none
+    int resumedLearnts;// learnt clauses of 'checkpoint' restored by 'resume'
+    ClauseCache *clauseCache;
+    BrokerClient *broker;
+    uint64_t sentLB;// last lower bound sent to 'broker'
+    uint64_t nextSync;// conflicts of the next synchronisation point
+    double gap;// see 'stopAtGap', negative for none
+    Solver *enumerating;// SAT solver of 'enumeratePlans' while it solves
+    std::mutex enumeratingLock;
+    bool interrupted;// by 'interrupt'
+    // Makes 'S' call 'recordBound' and 'recordSolver'.
+    void installHooks();
+    void initCheckpoint(const std::string &config);
+    void recordBound(uint64_t cost);
+    void recordSolver(Solver *solver);
+    // Best lower bound known: 'lowerBound' or that of 'S'.
+    uint64_t bestLowerBound();
+    void checkGap();
+#endif
+};
+
+#endif //TRAIN_SCHEDULE_OPTIMISATION_TIMETABLER_H
@@ -0,0 +1,300 @@
+/*!
+ * Timetabler Copyright (c) 2019 Alexandre Lemos, Pedro T Monteiro, Ines Lynce
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef MAXSATNID
+#define MAXSATNID 1
+#endif
+
+#include "libtimetabler.h"
+
+#if MAXSATNID==1
+#include <algorithm>
+#include <chrono>
+
+#include "../solver/TT-Open-WBO-Inc/algorithms/Alg_LinearSU.h"
+#include "../solver/TT-Open-WBO-Inc/algorithms/Alg_LinearSU_Clustering.h"
+#include "../solver/TT-Open-WBO-Inc/algorithms/Alg_LinearSU_Mod.h"
+#include "../solver/TT-Open-WBO-Inc/algorithms/Alg_MSU3.h"
+#include "../solver/TT-Open-WBO-Inc/algorithms/Alg_OLL.h"
+#include "../solver/TT-Open-WBO-Inc/algorithms/Alg_OLL_Mod.h"
+#include "../solver/TT-Open-WBO-Inc/algorithms/Alg_PartMSU3.h"
+#include "../solver/TT-Open-WBO-Inc/algorithms/Alg_WBO.h"
+#include "../solver/TT-Open-WBO-Inc/algorithms/Alg_OBV.h"
+#include "../solver/TT-Open-WBO-Inc/algorithms/Alg_BLS.h"
+
+using namespace openwbo;
+
+namespace libtimetabler {
+
+MaxSAT *newAlgorithm(const Options &options, MaxSATFormula *formula) {
+    // Weights only appear when the objective is converted by 'loadFormula',
+    // so every encoding is still unweighted here.
+    if (formula->getProblemType() == _UNWEIGHTED_) {
+        MaxSAT *S = new OLL(options.verbosity, options.cardinality);
+        S->setSATThreads(options.satThreads);
+        return S;
+    }
+
+    Statistics rounding_statistic = static_cast<Statistics>(options.roundingStrategy);
+    MaxSAT *S = NULL;
+    switch (options.algorithm) {
+        case _ALGORITHM_WBO_:
+            S = new WBO(options.verbosity, options.weightStrategy, options.symmetry, options.symmetryLimit);
+            break;
+
+        case _ALGORITHM_LINEAR_SU_:
+            if (options.clusterAlgorithm == 1) {
+                S = new LinearSUMod(options.verbosity, options.bmo, options.cardinality, options.pb,
+                                    ClusterAlg::_DIVISIVE_, rounding_statistic, options.numClusters);
+                static_cast<LinearSUMod *>(S)->initializeCluster();
+            } else {
+                S = new LinearSU(options.verbosity, options.bmo, options.cardinality, options.pb);
+            }
+            break;
+
+        case _ALGORITHM_PART_MSU3_:
+            S = new PartMSU3(options.verbosity, options.partitionStrategy, options.graphType, options.cardinality);
+            break;
+
+        case _ALGORITHM_MSU3_:
+            S = new MSU3(options.verbosity);
+            break;
+
+        case _ALGORITHM_LSU_CLUSTER_:
+            S = new LinearSUClustering(options.verbosity, options.bmo, options.cardinality, options.pb,
+                                       ClusterAlg::_DIVISIVE_, rounding_statistic, options.numClusters);
+            if (options.clusterAlgorithm == 1)
+                static_cast<LinearSUClustering *>(S)->initializeCluster();
+            break;
+
+        case _ALGORITHM_LSU_MRSBEAVER_:
+            S = new OBV(options.verbosity, options.cardinality, options.conflicts, options.iterations, options.local);
+            break;
+
+        case _ALGORITHM_LSU_MCS_:
+            S = new BLS(options.verbosity, options.cardinality, options.conflicts, options.iterations, options.local);
+            break;
+
+        case _ALGORITHM_OLL_:
+            if (options.clusterAlgorithm == 1) {
+                S = new OLLMod(options.verbosity, options.cardinality, ClusterAlg::_DIVISIVE_,
+                               rounding_statistic, options.numClusters);
+                static_cast<OLLMod *>(S)->initializeCluster();
+            } else {
+                S = new OLL(options.verbosity, options.cardinality);
+            }
+            break;
+    }
+    if (S != NULL)
+        S->setSATThreads(options.satThreads);
+    return S;
+}
+
+// Copies the plan decoded from 'model' into 'result'.
+static void collect(Timetabler &request, vec<lbool> &model, Result &result) {
+    if (model.size() == 0)
+        return;
+    request.decodeModel(model);
+    std::map<std::string,std::map<int,train_run_sections*>>::iterator it = request.instance.results.begin();
+    while (it != request.instance.results.end()) {
+        std::map<int,train_run_sections*>::iterator it1 = it->second.begin();
+        while (it1 != it->second.end()) {
+            result.train_runs[it->first][it1->first] = *it1->second;
+            it1++;
+        }
+        it++;
+    }
+}
+
+// Runs 'search', which returns the status of the request and may fill the
+// rest of 'result', and turns the errors of a request into an _ERROR_ result.
+static void run(Result &result, ProgressCallback progress,
+                std::function<StatusCode(std::function<void(uint64_t)>)> search) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    try {
+        result.status = search([&](uint64_t cost) {
+            result.cost = cost;
+            if (progress) {
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                progress(cost, elapsed.count());
+            }
+        });
+    } catch (std::runtime_error &e) {
+        result.status = _ERROR_;
+        result.error = e.what();
+    } catch (NSPACE::OutOfMemoryException &) {
+        result.status = _ERROR_;
+        result.error = "Out of memory";
+    }
+}
+
+// Encodes and solves the instance held by 'request'.
+static Result solve(Timetabler &request, const Options &options, ProgressCallback progress) {
+    Result result;
+    run(result, progress, [&](std::function<void(uint64_t)> bound) {
+        request.option = options.optTime;
+        request.relax = options.relax;
+        request.delays = options.delays;
+        request.activations = options.diagnose;
+        request.horizon = options.horizon;
+        request.genEncoding();
+        request.widenHorizon();
+        request.S = newAlgorithm(options, request.maxsat_formula);
+        if (request.S == NULL)
+            throw std::runtime_error("Invalid MaxSAT algorithm");
+        if (options.diagnose) {
+            bool minimal;
+            if (request.diagnose(options.musPropagations, result.conflict, minimal) == l_False && !options.relax)
+                return _UNSATISFIABLE_;
+        }
+        request.computeLowerBound(options.lbConflicts);
+        if (options.gap >= 0)
+            request.stopAtGap(options.gap / 100);
+        StatusCode status = request.solve(options.timeLimit, bound);
+        result.timedOut = request.timedOut;
+        result.lowerBound = std::max(request.lowerBound, request.S->getLowerBound());
+        result.relaxed = request.relaxedGroups(request.S->model);
+        collect(request, request.S->model, result);
+        return status;
+    });
+    return result;
+}
+
+Result Session::solve(const Instance &instance, ProgressCallback progress) {
+    request.reset(new Timetabler());
+    request->setInstance(instance);
+    return libtimetabler::solve(*request, options, progress);
+}
+
+Result Session::solve(const char *json, size_t length, ProgressCallback progress) {
+    request.reset(new Timetabler());
+    try {
+        if (!request->readJSON(json, length)) {
+            Result result;
+            result.status = _ERROR_;
+            result.error = "Invalid JSON";
+            return result;
+        }
+    } catch (std::runtime_error &e) {
+        Result result;
+        result.status = _ERROR_;
+        result.error = e.what();
+        return result;
+    }
+    return libtimetabler::solve(*request, options, progress);
+}
+
+Result Session::reoptimise(const Delta &delta, uint64_t perturbationWeight, ProgressCallback progress) {
+    Result result;
+    if (!request) {
+        result.status = _ERROR_;
+        result.error = "No plan to re-optimise";
+        return result;
+    }
+    run(result, progress, [&](std::function<void(uint64_t)> bound) {
+        StatusCode status = request->reoptimise(delta, [&](MaxSATFormula *formula) {
+            return newAlgorithm(options, formula);
+        }, perturbationWeight, options.timeLimit, bound);
+        result.timedOut = request->timedOut;
+        collect(*request, request->S->model, result);
+        return status;
+    });
+    return result;
+}
+
+static std::vector<Result> solveScenarios(Timetabler &request, const std::vector<Scenario> &scenarios,
+                                          const Options &options, int threads) {
+    std::vector<Result> results(scenarios.size());
+    std::vector<ScenarioOutcome> outcomes;
+    try {
+        request.option = options.optTime;
+        request.activations = true;
+        request.relax = options.relax;
+        request.delays = options.delays;
+        request.genEncoding();
+        ScenarioSolver solver(request, [&](MaxSATFormula *formula) {
+            return newAlgorithm(options, formula);
+        }, options.timeLimit, threads, options.musPropagations);
+        solver.solve(scenarios, outcomes);
+        for (size_t i = 0; i < outcomes.size(); i++) {
+            results[i].status = outcomes[i].status;
+            results[i].timedOut = outcomes[i].timedOut;
+            results[i].cost = outcomes[i].cost;
+            results[i].error = outcomes[i].error;
+            results[i].conflict = outcomes[i].conflict;
+            results[i].relaxed = outcomes[i].relaxed;
+            vec<lbool> model;
+            for (lbool v: outcomes[i].model)
+                model.push(v);
+            collect(request, model, results[i]);
+        }
+    } catch (std::runtime_error &e) {
+        for (Result &result: results) {
+            result.status = _ERROR_;
+            result.error = e.what();
+        }
+    } catch (NSPACE::OutOfMemoryException &) {
+        for (Result &result: results) {
+            result.status = _ERROR_;
+            result.error = "Out of memory";
+        }
+    }
+    return results;
+}
+
+std::vector<Result> solveScenarios(const Instance &instance, const std::vector<Scenario> &scenarios,
+                                   const Options &options, int threads) {
+    Timetabler request;
+    request.setInstance(instance);
+    return solveScenarios(request, scenarios, options, threads);
+}
+
+std::vector<Result> solveScenarios(const char *json, size_t length, const std::vector<Scenario> &scenarios,
+                                   const Options &options, int threads) {
+    Timetabler request;
+    std::string error = "Invalid JSON";
+    try {
+        if (request.readJSON(json, length))
+            return solveScenarios(request, scenarios, options, threads);
+    } catch (std::runtime_error &e) {
+        error = e.what();
+    }
+    std::vector<Result> results(scenarios.size());
+    for (Result &result: results) {
+        result.status = _ERROR_;
+        result.error = error;
+    }
+    return results;
+}
+
+Result solve(const Instance &instance, const Options &options, ProgressCallback progress) {
+    return Session(options).solve(instance, progress);
+}
+
+Result solve(const char *json, size_t length, const Options &options, ProgressCallback progress) {
+    return Session(options).solve(json, length, progress);
+}
+
+} // namespace libtimetabler
+
+#endif
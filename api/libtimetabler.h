@@ -0,0 +1,117 @@
+//
+// Library interface of the timetabler (libtimetabler.a).
+//
+
+#ifndef TRAIN_SCHEDULE_OPTIMISATION_LIBTIMETABLER_H
+#define TRAIN_SCHEDULE_OPTIMISATION_LIBTIMETABLER_H
+
+#include <stdint.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Scenarios.h"
+#include "Timetabler.h"
+
+#if MAXSATNID==1
+
+namespace libtimetabler {
+
+// Same meaning and defaults as the command line options of the same name.
+struct Options {
+    int optTime = 2;              // -opt-time
+    int algorithm = 6;            // -algorithm
+    int verbosity = 0;            // -verbosity
+    bool bmo = true;              // -bmo
+    int cardinality = 1;          // -cardinality
+    int pb = 1;                   // -pb
+    int weightStrategy = 2;       // -weight-strategy
+    bool symmetry = true;         // -symmetry
+    int symmetryLimit = 500000;   // -symmetry-limit
+    int clusterAlgorithm = 1;     // -ca
+    int numClusters = 100000;     // -c
+    int roundingStrategy = 0;     // -rs
+    int partitionStrategy = 2;    // -partition-strategy
+    int graphType = 2;            // -graph-type
+    int conflicts = 10000;        // -conflicts
+    int iterations = 100000;      // -iterations
+    bool local = false;           // -local
+    int satThreads = 1;           // -sat-threads
+    int lbConflicts = 10000;      // -lb-conflicts
+    double gap = -1;              // -gap, in percent
+    bool relax = false;           // -relax
+    bool delays = false;          // -delays
+    bool diagnose = false;        // -diagnose
+    int horizon = 0;              // -horizon, with delays and optTime 2
+    int64_t musPropagations = ScenarioSolver::defaultMUSPropagations; // -mus-propagations
+
+    double timeLimit = 0;         // wall-clock seconds, 0 for none
+};
+
+struct Result {
+    StatusCode status = _UNKNOWN_;
+    bool timedOut = false;        // the best solution so far is returned
+    uint64_t cost = 0;            // of the returned solution
+    uint64_t lowerBound = 0;      // best proven, see Timetabler::computeLowerBound
+    std::string error;            // set when status is _ERROR_
+    // service intention id -> sequence number -> section
+    std::map<std::string, std::map<int, train_run_sections>> train_runs;
+    // Groups that explain an infeasible scenario (see Scenarios.h), or an
+    // infeasible instance with Options::diagnose.
+    std::vector<std::string> conflict;
+    // Groups violated by the solution in relaxation mode (Options::relax).
+    std::vector<std::string> relaxed;
+};
+
+// Called with every improved solution: its cost and the elapsed seconds.
+typedef std::function<void(uint64_t, double)> ProgressCallback;
+
+// Both entry points are reentrant: calls on different instances may run
+// concurrently from different threads. The TorcOpenWbo parameters (Torc.h)
+// are process wide and must be set before the first call.
+Result solve(const Instance &instance, const Options &options = Options(),
+             ProgressCallback progress = nullptr);
+Result solve(const char *json, size_t length, const Options &options = Options(),
+             ProgressCallback progress = nullptr);
+
+// Solves every scenario of one instance on a single encoding, spread over
+// 'threads' threads (see Scenarios.h). 'options.timeLimit' applies to each
+// scenario. The results are in the order of 'scenarios'.
+std::vector<Result> solveScenarios(const Instance &instance, const std::vector<Scenario> &scenarios,
+                                   const Options &options = Options(), int threads = 1);
+std::vector<Result> solveScenarios(const char *json, size_t length, const std::vector<Scenario> &scenarios,
+                                   const Options &options = Options(), int threads = 1);
+
+// A solved request kept alive for re-optimisation after delays and other
+// disruptions (see Timetabler::reoptimise). 'reoptimise' may be called any
+// number of times after a successful 'solve'; each result is the reference
+// plan of the next call. The cost of a re-optimisation is that of its
+// minimal-perturbation objective.
+class Session {
+public:
+    explicit Session(const Options &options = Options()) : options(options) {}
+
+    Result solve(const Instance &instance, ProgressCallback progress = nullptr);
+    Result solve(const char *json, size_t length, ProgressCallback progress = nullptr);
+    Result reoptimise(const Delta &delta, uint64_t perturbationWeight = 1,
+                      ProgressCallback progress = nullptr);
+
+    // Trains freed by the last 'reoptimise'.
+    int freedTrains() const { return request ? request->freedTrains : 0; }
+
+private:
+    Options options;
+    std::unique_ptr<Timetabler> request;
+};
+
+// Builds the MaxSAT algorithm selected by 'options' for an encoded request.
+// Returns NULL for an invalid algorithm.
+openwbo::MaxSAT *newAlgorithm(const Options &options, openwbo::MaxSATFormula *formula);
+
+} // namespace libtimetabler
+
+#endif
+
+#endif //TRAIN_SCHEDULE_OPTIMISATION_LIBTIMETABLER_H
@@ -0,0 +1,70 @@
+//
+// Conflicts per second of the Glucose solver of TT-Open-WBO-Inc, to compare
+// the default clause arena with the one of 'make ARENA64=1'. A random 3-SAT
+// formula near the threshold is searched with a conflict budget, so that
+// learnt clauses are allocated, reduced and garbage collected all along.
+//
+//   make bench && bench/arena [vars] [clauses per var] [solves] [conflicts per solve] [seed]
+//   make clean && make ARENA64=1 bench && bench/arena ...
+//
+// Both builds take the same search, so the conflicts must be equal too.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "core/Solver.h"
+
+using namespace NSPACE;
+
+static uint64_t state;
+
+static uint64_t draw() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+int main(int argc, char **argv) {
+    int vars = argc > 1 ? atoi(argv[1]) : 5000;
+    double ratio = argc > 2 ? atof(argv[2]) : 4.2;
+    int solves = argc > 3 ? atoi(argv[3]) : 3;
+    int budget = argc > 4 ? atoi(argv[4]) : 30000;
+    state = argc > 5 ? strtoull(argv[5], NULL, 10) : 1;
+    if (state == 0)
+        state = 1;
+
+    Solver solver;
+    solver.verbosity = -1;
+    for (int v = 0; v < vars; v++)
+        solver.newVar();
+    vec<Lit> clause;
+    for (int i = 0; i < (int) (vars * ratio); i++) {
+        clause.clear();
+        for (int j = 0; j < 3; j++)
+            clause.push(mkLit(draw() % vars, draw() & 1));
+        solver.addClause(clause);
+    }
+
+    vec<Lit> assumptions;
+    uint64_t conflicts = solver.conflicts;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    lbool result = l_Undef;
+    for (int i = 0; i < solves && result == l_Undef; i++) {
+        solver.setConfBudget(budget);
+        result = solver.solveLimited(assumptions);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    conflicts = solver.conflicts - conflicts;
+    printf("%s: %d vars, %d clauses, %s, %" PRIu64 " conflicts in %.3f s, %.0f conflicts/s\n",
+#ifdef GLUCOSE_ARENA64
+           "arena64",
+#else
+           "default",
+#endif
+           vars, (int) (vars * ratio), result == l_True ? "SAT" : result == l_False ? "UNSAT" : "UNKNOWN",
+           conflicts, seconds, conflicts / seconds);
+    return 0;
+}
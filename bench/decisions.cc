@@ -0,0 +1,74 @@
+//
+// Decisions per second of the Glucose solver of TT-Open-WBO-Inc, the cost of
+// 'pickBranchLit'. An under-constrained random 3-CNF is solved again and
+// again, so that the search is mostly decisions and their propagations, with
+// the optimistic (target variables) and conservative (saved phases) polarity
+// strategies of Torc on or off.
+//
+//   make bench && bench/decisions [vars] [clauses per var] [solves] [seed] [strategies]
+//
+// 'strategies' is "both" (default), "optimistic", "conservative" or "none".
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "core/Solver.h"
+#include "../solver/TT-Open-WBO-Inc/Torc.h"
+
+using namespace NSPACE;
+
+static uint64_t state;
+
+static uint64_t draw() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+int main(int argc, char **argv) {
+    int vars = argc > 1 ? atoi(argv[1]) : 200000;
+    double ratio = argc > 2 ? atof(argv[2]) : 2.0;
+    int solves = argc > 3 ? atoi(argv[3]) : 20;
+    state = argc > 4 ? strtoull(argv[4], NULL, 10) : 1;
+    const char *strategies = argc > 5 ? argv[5] : "both";
+    if (state == 0)
+        state = 1;
+    bool optimistic = strcmp(strategies, "both") == 0 || strcmp(strategies, "optimistic") == 0;
+    bool conservative = strcmp(strategies, "both") == 0 || strcmp(strategies, "conservative") == 0;
+    // Read once by the constructor of the solver
+    Torc::Instance()->SetPolOptimistic(optimistic);
+    Torc::Instance()->SetPolConservative(conservative);
+
+    Solver solver;
+    solver.verbosity = -1;
+    for (int v = 0; v < vars; v++)
+        solver.newVar();
+    vec<Lit> clause;
+    for (int i = 0; i < (int) (vars * ratio); i++) {
+        clause.clear();
+        for (int j = 0; j < 3; j++)
+            clause.push(mkLit(draw() % vars, draw() & 1));
+        solver.addClause(clause);
+    }
+    // Every other variable is a target, and every variable has a phase
+    solver._target_vars.growTo(vars);
+    for (int v = 0; v < vars; v += 2)
+        solver._target_vars.insert(v);
+    for (int v = 0; v < vars; v++)
+        solver._user_phase_saving.push(draw() & 1 ? l_True : l_False);
+
+    uint64_t decisions = solver.decisions;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int sat = 0;
+    for (int i = 0; i < solves; i++)
+        sat += solver.solve() ? 1 : 0;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    decisions = solver.decisions - decisions;
+    printf("%s: %d vars, %d clauses, %d/%d SAT, %" PRIu64 " decisions in %.3f s, %.0f decisions/s\n",
+           strategies, vars, (int) (vars * ratio), sat, solves, decisions, seconds, decisions / seconds);
+    return 0;
+}
@@ -50,6 +50,8 @@
 #include <vector>
 #include <cstring>
 #include <limits.h>
+#include <atomic>
+#include <thread>
 #if MAXSATNID <5
 #ifdef SIMP
 #include "simp/SimpSolver.h"
@@ -140,6 +142,20 @@ int cardinalityB;
 #include "solver/Open-WBO-Inc/algorithms/Alg_BLS.h"
 #endif
 
+//Per-request state; defines RAPIDJSON_ASSERT, so it comes before RapidJSON
+#include "api/Timetabler.h"
+#if MAXSATNID<5
+#include "api/FormulaCache.h"
+#include "api/FormulaIO.h"
+#include "api/Portfolio.h"
+#endif
+#if MAXSATNID==1
+#include "api/ClauseCache.h"
+#include "api/Scenarios.h"
+#include "api/Server.h"
+#include "api/libtimetabler.h"
+#endif
+
 //RapidJSON reader
 #include "rapidjson/reader.h"
 #include "rapidjson/document.h"
@@ -165,13 +181,12 @@ int cardinalityB;
 #define VER VER_(VERSION)
 #define SOLVERM VER_(SUPERSOLVERNAME)
 
-Instance  instance;
-int minV=INT_MAX; int maxV=0; int diffV=0;
-Instance readJSONFile(char *);
-int size=-1;
+Timetabler *timetabler = NULL;//The request solved from the command line
 
 #if MAXSATNID <5
 using NSPACE::BoolOption;
+using NSPACE::DoubleOption;
+using NSPACE::DoubleRange;
 using NSPACE::IntOption;
 using NSPACE::IntRange;
 using NSPACE::OutOfMemoryException;
@@ -187,8 +202,6 @@ using namespace openwbo;
 //Print Solver stats
 void printSolverStats(MaxSATFormula*maxsat_formula,double initial_time);
 
-int getVariableID(std::string varName,MaxSATFormula*maxsat_formula);
-
 
 
 
@@ -197,30 +210,106 @@ MaxSAT *S = NULL;
 int option;
 MaxSATFormula *maxsat_formula;
 
-Instance readJSONFile(char *);
+// Worker of a portfolio (see Portfolio.h), with any backend
+StringOption broker("Timetabler", "broker",
+                    "Share incumbents with the broker of a portfolio (unix:<path> or <host>:<port>).\n", NULL);
+BrokerClient brokerClient;
+
+// Any backend
+BoolOption relax("Timetabler", "relax",
+                 "Let section requirements be violated at the cost of their entry delay weight,\n"
+                 "for instances that are infeasible as specified.\n", false);
+BoolOption delays("Timetabler", "delays",
+                  "Add the entry delays of the section requirements, at their entry delay weight per\n"
+                  "minute, to the objective (with -opt-time=2).\n", false);
+BoolOption pesp("Timetabler", "pesp",
+                "Read the input file as a PESP instance (PESPlib activities) and write its timetable.\n", false);
+IntOption pespPeriod("Timetabler", "pesp-period",
+                     "Period of a PESP instance whose file does not give it.\n", 60, IntRange(1, INT32_MAX));
+IntOption encodeThreads("Timetabler", "encode-threads",
+                        "Threads encoding the trains (0=one per core).\n", 0, IntRange(0, INT32_MAX));
+StringOption formulaCache("Timetabler", "formula-cache",
+                          "Compiled encoding of the instance (see FormulaCache.h): loaded instead of encoding\n"
+                          "the instance when it was saved for the same input file and encoding options,\n"
+                          "otherwise written after encoding.\n", NULL);
+StringOption exportWCNF("Timetabler", "export-wcnf",
+                        "Write the encoding in WCNF, with its variable names in <file>.varmap, and exit.\n", NULL);
+StringOption exportOPB("Timetabler", "export-opb",
+                       "Write the encoding in OPB, with its variable names in <file>.varmap, and exit.\n", NULL);
+StringOption importSolution("Timetabler", "import-solution",
+                            "Decode the assignment another solver found for the exported encoding (its \"v\"\n"
+                            "lines) into the solution file, and exit. Variables missing from the v-lines\n"
+                            "are false.\n", NULL);
+
+// Sends the result of the search to the broker, if any.
+static void reportToBroker(StatusCode code) {
+    if (!brokerClient.connected())
+        return;
+    if (S->model.size() > 0)
+        brokerClient.sendBound(timetabler->planCost(S->model), S->model);
+    brokerClient.sendDone(code);
+}
+
 Instance readOutputJSONFile(char*);
-void outputJSONFile(Instance instance);
 
+#if MAXSATNID==1
+ClauseCache clauseCache;
+std::string clauseCacheFile;//-clause-cache
+int kSolutions = 1;//-k-solutions
+double kTolerance;//-k-tolerance, as a fraction of the best cost
+int kDistance;//-k-distance
+double kTime;//-k-time
+int horizon = 0;//-horizon
+#endif
+
+#if MAXSATNID!=1
 static void SIGINT_exit(int signum) {
-    S->printAnswer(_UNKNOWN_);
+    if (S != NULL)
+        S->printAnswer(_UNKNOWN_);
     exit(_UNKNOWN_);
 }
+#else
+// SIGTERM, SIGXCPU (-cpu-lim) and the broker stop the search through
+// S->interrupt(), as the watchdog of the server does, and the alternative
+// plans of -k-solutions through timetabler->interrupt(): the best model, the
+// checkpoint and the clause cache are then written on the normal exit path,
+// not in a signal handler. The signals are blocked in every thread and taken
+// by 'waitForStop'.
+static std::atomic<bool> stopRequested(false);
+
+static void requestStop() {
+    stopRequested = true;
+    if (S == NULL) {
+        // Still encoding: nothing to save yet
+        fflush(stdout);
+        std::_Exit(_UNKNOWN_);
+    }
+    S->interrupt();
+    timetabler->interrupt();
+}
 
+static void waitForStop(sigset_t signals) {
+    int signum;
+    while (sigwait(&signals, &signum) == 0)
+        requestStop();
+}
+#endif
 
-void newVar(std::string,MaxSATFormula*maxsat_formula);
 
 void tt(int argc, char **argv);
 void loandra(int argc, char **argv);
 void LinSBPS(int argc, char **argv);
 void Open_WBO_Inc(int argc, char **argv);
-void genEncoding(int argc, char **argv);
+// With 'primary', the encoding of the run itself (rather than of a scenario
+// or a portfolio worker), which the formula cache, export and import apply
+// to.
+void genEncoding(int argc, char **argv, bool activations = false, bool primary = false);
 
 #endif
 
 
 using namespace rapidjson;
 using namespace std;
-  Instance readPESPInstance(char* local);
 
 #if MAXSATNID==5
 #include "solver/SATLike/basis_pms.h"
@@ -228,7 +317,8 @@ using namespace std;
 #include <signal.h>
 static Satlike s;
 int main(int argc, char **argv) {
-    instance= readJSONFile(argv[1]);
+    timetabler = new Timetabler();
+    timetabler->readJSONFile(argv[1]);
 
     cout<<"This is Satlike3.0 solver"<<endl;
     vector<int> init_solution;
@@ -244,7 +334,6 @@ int main(int argc, char **argv) {
     //    readOutputJSONFile(argv[1]);
     double initial_time = cpuTime();
     clock_t myTimeStart = clock();
-    //readPESPInstance(argv[1]);
 
     try {
 #if defined(__linux__)
@@ -308,14 +397,13 @@ int main(int argc, char **argv) {
         S->loadFormula(maxsat_formula);
         printSolverStats(maxsat_formula,initial_time);
 
-        std::string delimiter = "^";
-
         StatusCode code;
 #if MAXSATNID==4
         int starting_precision = -1;
         int n_ini_vars = maxsat_formula->n_initial_vars;
         while(1==1){
         code = S->search();
+        reportToBroker(code);
 
         vec<lbool> previous_model;
         for (int i = 0; i < S->model.size(); i++) {
@@ -345,62 +433,61 @@ int main(int argc, char **argv) {
             S->_use_only_original_vars = true;
         }
         }
+#elif MAXSATNID==1
+        if (timetabler->checkpoint.optimum) {
+            // Proven by the run that saved the checkpoint
+            timetabler->bestModel();
+            S->printAnswer(_OPTIMUM_);
+            code = _OPTIMUM_;
+        } else {
+            try {
+                code = S->search();
+            } catch (InterruptedException &) {
+                if (stopRequested) {
+                    // SIGTERM, SIGXCPU or the broker (see 'requestStop')
+                    code = _UNKNOWN_;
+                    timetabler->bestModel();
+                } else {
+                    // Stopped by -gap
+                    code = timetabler->gapStatus;
+                    printf("c gap reached: UB %" PRIu64 ", LB %" PRIu64 "\n",
+                           timetabler->planCost(S->model), std::max(timetabler->lowerBound, S->getLowerBound()));
+                }
+                S->printAnswer(code);
+            }
+        }
+        reportToBroker(code);
+        std::string error;
+        if (!timetabler->saveCheckpoint(code == _OPTIMUM_, error))
+            printf("c Warning: %s\n", error.c_str());
+        if (!clauseCacheFile.empty() && !clauseCache.save(clauseCacheFile, error))
+            printf("c Warning: %s\n", error.c_str());
+        if (stopRequested)
+            exit(_UNKNOWN_);
+        if (kSolutions > 1 && S->model.size() > 0 && !pesp) {
+            // The plan of the search, then the alternatives
+            uint64_t best = timetabler->planCost(S->model);
+            auto write = [](int i, vec<lbool> &model, uint64_t cost) {
+                printf("c solution %d: cost %" PRIu64 "\n", i, cost);
+                timetabler->decodeModel(model);
+                timetabler->outputJSONFile("solution" + std::to_string(i));
+            };
+            write(1, S->model, best);
+            timetabler->enumeratePlans(S->model, kSolutions - 1, best + (uint64_t) floor(best * kTolerance), kDistance,
+                                       kTime, [&write](int i, vec<lbool> &model, uint64_t cost) { write(i + 1, model, cost); });
+        }
 #else
          code = S->search();
+         reportToBroker(code);
 #endif
+        for (const std::string &group: timetabler->relaxedGroups(S->model))
+            printf("c relaxed %s\n", group.c_str());
+        if (pesp && S->model.size() > 0)
+            printf("c weighted tension %" PRIu64 "\n", timetabler->outputPESPFile(S->model));
         std::cout<<(clock() - myTimeStart) / CLOCKS_PER_SEC<<std::endl;
         std::exit(1);
-        while(code!=_SATISFIABLE_&&code!=_OPTIMUM_){
-            S->getConflict();
-            for (int i = 0; i < S->errorP.size(); i++) {
-                indexMap::const_iterator iter = maxsat_formula->getIndexToName().find(i);
-                if (iter != maxsat_formula->getIndexToName().end()) {
-                    newVar(iter->second,maxsat_formula);
-                }
-            }
-            code = S->search();
-        }
-        for (int i = 0; i < S->model.size(); i++) {
-                indexMap::const_iterator iter = maxsat_formula->getIndexToName().find(i);
-                if (iter != maxsat_formula->getIndexToName().end()) {
-                    if (S->model[i] != l_False) {
-                        std::string id =iter->second.substr(iter->second.find(delimiter) + 1, iter->second.size());
-                        std::string sid = id.substr(id.find(delimiter) + 1, id.size());
-                        std::string rid = id.substr(0,id.find(delimiter));
-                        train_run_sections * trs = new train_run_sections();
-                        trs->entry_time="";
-                        trs->exit_time="";
-                        trs->route=rid;
-                        trs->route_section_id=rid+"#"+sid;
-                        trs->route_path_str=instance.sectionMap[rid][std::stoi(sid)]->route_pathName;
-                        for (int j = 0; j < instance.train.size(); ++j) {
-                            if(instance.train[j].id.compare(rid)!=0)
-                                continue;
-                            for (Requirement *r: instance.train[j].t) {
-                                for(int k=0; k<instance.markerMap[instance.train[j].id+"^"+r->section_marker].size();k++) {
-                                      //  printf("%s %s %s %s \n",rid.c_str(),sid.c_str(),std::to_string(instance.markerMap[instance.train[j].id+"^"+r->section_marker][k]->sequence_number).c_str(),r->section_marker.c_str());
-                                    if (std::to_string(instance.markerMap[instance.train[j].id+"^"+r->section_marker][k]->sequence_number).compare(sid) == 0) {
-                                        trs->section_requirement=r->section_marker;
-                                        break;
-                                    }
-                                }
-                            }
-                        }
-                        if(instance.results.find(rid)!=instance.results.end())
-                            instance.results[rid].insert(std::pair<int,train_run_sections*>(std::stoi(sid),trs));
-                        else{
-                            std::map<int,train_run_sections*> trsv;
-                            trsv.insert(std::pair<int,train_run_sections*>(std::stoi(sid),trs));
-                            instance.results.insert(std::pair<std::string,std::map<int,train_run_sections*>>(rid,trsv));
-                        }
-
-
-                    }
-
-                }
-            }
-
-            outputJSONFile(instance);
+        timetabler->decodeModel(S->model);
+        timetabler->outputJSONFile();
 
 
 
@@ -419,181 +506,137 @@ int main(int argc, char **argv) {
 }
 
 
-void genEncoding(int argc, char **argv) {
-
-    maxsat_formula = new MaxSATFormula();
-    maxsat_formula->setFormat(_FORMAT_PB_);
-    instance= readJSONFile(argv[1]);
-    //stat(instance,diffV);
-    //std::exit(1);
-    int secV=0;
+// Loads the compiled encoding of the instance of 'input' from -formula-cache
+// into 'timetabler', if it was saved with the same encoding options.
+// Otherwise returns false with the key to save the encoding under in 'key'.
+static bool loadCompiledEncoding(const char *input, uint64_t &key) {
+    int window = 0;
+#if MAXSATNID==1
+    window = horizon;
+#endif
+    std::string options = "opt-time=" + std::to_string(timetabler->option) +
+                          " activations=" + std::to_string((int) timetabler->activations) +
+                          " relax=" + std::to_string((int) timetabler->relax) +
+                          " delays=" + std::to_string((int) timetabler->delays) +
+                          " horizon=" + std::to_string(window);
+    std::string error;
+    if (!FormulaCache::key(input, options, key, error)) {
+        printf("c Error: %s\n", error.c_str());
+        printf("s UNKNOWN\n");
+        exit(_ERROR_);
+    }
+    std::string label;
+    MaxSATFormula *formula = FormulaCache::load((const char *) formulaCache, key, label, error);
+    if (formula == NULL) {
+        printf("c formula cache: %s\n", error.c_str());
+        return false;
+    }
+    // The instance itself is still read, to decode the plan.
+    if (!timetabler->readJSONFile(input)) {
+        printf("c Error: could not read %s\n", input);
+        printf("s UNKNOWN\n");
+        exit(_ERROR_);
+    }
+    if (timetabler->relax)
+        timetabler->activations = true;
+    timetabler->maxsat_formula = formula;
+    printf("c formula cache: loaded %d variables of %s\n", formula->nVars(), label.c_str());
+    return true;
+}
 
-    for (int i = 0; i < instance.train.size() ; ++i) {
-            for (int j = 0; j < instance.route[instance.train[i].route].totalSeq; ++j) {
-                secV++;
-                //getVariableID("t^"+instance.train[i].id+"^"+std::to_string(j),maxsat_formula);
-            }
+// -export-wcnf, -export-opb and -import-solution, which exit once done.
+static void exchangeEncoding() {
+    if (exportWCNF == NULL && exportOPB == NULL && importSolution == NULL)
+        return;
+    std::string error;
+    if ((exportWCNF != NULL && !FormulaIO::writeWCNF((const char *) exportWCNF, maxsat_formula, error)) ||
+        (exportOPB != NULL && !FormulaIO::writeOPB((const char *) exportOPB, maxsat_formula, error))) {
+        printf("c Error: %s\n", error.c_str());
+        exit(_ERROR_);
+    }
+    if (exportWCNF != NULL || exportOPB != NULL)
+        printf("c exported %d variables, %d hard clauses, %d cardinality and %d PB constraints\n",
+               maxsat_formula->nVars(), maxsat_formula->nHard(), maxsat_formula->nCard(), maxsat_formula->nPB());
+    if (importSolution != NULL) {
+        vec<lbool> model;
+        int violated = FormulaIO::readAssignment((const char *) importSolution, maxsat_formula, model, error);
+        if (violated < 0) {
+            printf("c Error: %s\n", error.c_str());
+            printf("s UNKNOWN\n");
+            exit(_ERROR_);
         }
-    std::cout<<secV<<std::endl;
-
-
-    std::map<std::string, std::map<int,std::vector<route_section*>>>::iterator
-    it = instance.end.begin();;
-
-    while (it != instance.end.end()) {
-            std::map<int,std::vector<route_section*>>::iterator it1 = it->second.begin();
-            while (it1 != it->second.end()) {
-                if(it1->second[0]->route_alternative_marker_at_entry.size()==0){
-                    vec<Lit> lit;
-                    lit.push(~mkLit(getVariableID("t^"+it->first+"^"+std::to_string(it1->first),maxsat_formula)));
-                    //printf("~%s ",("t^"+it->first+"^"+std::to_string(it1->first)).c_str());
-                    for (int i = 1; i < it1->second.size(); ++i) {
-                        lit.push(mkLit(getVariableID("t^"+it->first+"^"+std::to_string(it1->second[i]->sequence_number),maxsat_formula)));
-                        //printf("%s ",("t^"+it->first+"^"+std::to_string(it1->second[i]->sequence_number)).c_str());
-
-                    }
-                    //printf("\n");
-                    //maxsat_formula->addHardClause(lit);
-                    lit.clear();
-                }
-                it1++;
-
-            }
-            it++;
-
+        if (violated > 0) {
+            printf("c Error: the assignment violates %d hard constraints\n", violated);
+            printf("s UNKNOWN\n");
+            exit(_ERROR_);
         }
-    printf("splits\n");
-    std::string delimiter = "^";
-    std::map<std::string,std::vector<route_section*>> ::iterator
-    it2 = instance.entryMap.begin();;
-
-    while (it2 != instance.entryMap.end()) {
-            for(int y=0; y<it2->second.size();y++) {
-                vec <Lit> lit;
-                std::string rid = it2->first.substr(it2->first.find(delimiter) + 1, it2->first.size());
-                if(instance.exitMap[it2->first].size()>0) {
-                    lit.push(~mkLit(getVariableID("t^" + rid + "^" + std::to_string(it2->second[y]->sequence_number),
-                                                  maxsat_formula)));
-                    //printf("~%s ", ("t^" + rid + "^" + std::to_string(it2->second[y]->sequence_number)).c_str());
-                    for (int i = 0; i < instance.exitMap[it2->first].size(); ++i) {
-                        lit.push(mkLit(getVariableID(
-                                "t^" + rid + "^" + std::to_string(instance.exitMap[it2->first][i]->sequence_number),
-                                maxsat_formula)));
-                        //printf("%s ", ("t^" + rid + "^" + std::to_string(instance.exitMap[it2->first][i]->sequence_number)).c_str());
-
-                    }
-                    //printf("\n");
-                    //maxsat_formula->addHardClause(lit);
-                    lit.clear();
-                }
-            }
-            it2++;
-
-
-
+        if (pesp) {
+            printf("c weighted tension %" PRIu64 "\n", timetabler->outputPESPFile(model));
+        } else {
+            printf("c cost %" PRIu64 "\n", timetabler->planCost(model));
+            timetabler->decodeModel(model);
+            timetabler->outputJSONFile();
         }
+    }
+    exit(0);
+}
 
-    printf("musts\n");
-    for (int j = 0; j < instance.train.size(); ++j) {
-
-            for(Requirement *r: instance.train[j].t){
-
-                vec<Lit> lit;
-                //printf("%s",r->section_marker.c_str());
-                    for(int k=0; k<instance.markerMap[instance.train[j].id+"^"+r->section_marker].size();k++){
-                        lit.push(mkLit(getVariableID(
-                                "t^" + instance.train[j].id + "^" + std::to_string(instance.markerMap[instance.train[j].id+"^"+r->section_marker][k]->sequence_number),maxsat_formula)));
-                    //printf("%s \n",("t^" + instance.train[j].id + "^" + std::to_string(instance.markerMap[instance.train[j].id+"^"+r->section_marker][k]->sequence_number)).c_str());
-                    }
-                    if(lit.size()!=0)
-                        maxsat_formula->addHardClause(lit);
-                    lit.clear();
-
-            }
-
+void genEncoding(int argc, char **argv, bool activations, bool primary) {
+    timetabler = new Timetabler();
+    timetabler->option = option;
+    timetabler->activations = activations;
+    timetabler->relax = relax;
+    timetabler->delays = delays;
+    timetabler->encodeThreads = encodeThreads;
+#if MAXSATNID==1
+    timetabler->horizon = horizon;
+#endif
+    // PESP instances are small enough to encode every time.
+    bool cached = primary && formulaCache != NULL && !pesp;
+    uint64_t key;
+    bool loaded = cached && loadCompiledEncoding(argv[1], key);
+    if (loaded) {
+        // Encoded, and widened, by the run that saved it
+    } else if (pesp) {
+        std::string error;
+        if (!timetabler->readPESPFile(argv[1], pespPeriod, error)) {
+            printf("c Error: %s\n", error.c_str());
+            printf("s UNKNOWN\n");
+            exit(_ERROR_);
         }
-
-
-    printf("Time\n");
-    int timeV=0;
-    if(((int) option) == 0) {
-            printf("0\n");
-            for (int j = 0; j < instance.train.size(); ++j) {
-                int s=0;
-                for(route_path rp: instance.route[instance.train[j].route].route_paths) {
-                    for (route_section *rs: rp.route_sections) {
-                        PB *p=new PB();
-                        for (int i = minV; i < maxV; ++i) {
-                            timeV++;
-                            p->addProduct(mkLit(getVariableID("s^"+instance.train[j].id+"^"+std::to_string(i)+"^"+std::to_string(s),maxsat_formula)),1);
-                        }
-                        if(p->_lits.size()>0)
-                            maxsat_formula->addPBConstraint(p);
-                        s++;
-
-
-                    }
-                }
-            }
-        } else if(((int) option) == 1) {
-            printf("1\n");
-            for (int j = 0; j < instance.train.size(); ++j) {
-                int s=0;
-                for(Requirement *r: instance.train[j].t){
-                    PB *p=new PB();
-                    for (int i = minV; i < maxV; ++i) {
-                        timeV++;
-                        p->addProduct(mkLit(getVariableID("s^"+instance.train[j].id+"^"+std::to_string(i)+"^"+std::to_string(s),maxsat_formula)),1);
-                    }
-                    if(p->_lits.size()>0)
-                        maxsat_formula->addPBConstraint(p);
-                    s++;
-
-
-                }
-
-            }
-        } else {
-            printf("2\n");
-            for (int j = 0; j < instance.train.size(); ++j) {
-                for(Requirement *r: instance.train[j].t){
-                    PB *p=new PB();
-                    for (int i = r->sec_entry_earliest; i <r->sec_exit_latest ; ++i) {
-                        timeV++;
-                        p->addProduct(mkLit(getVariableID("s^"+instance.train[j].id+"^"+std::to_string(i)+"^"+r->section_marker,maxsat_formula)),1);
-                    }
-                    if(p->_lits.size()>0)
-                        maxsat_formula->addPBConstraint(p);
-                    //printf("ee: %d el: %d xe: %d xl: %d\n",r->sec_entry_earliest,r->sec_entry_latest,
-                      //         r->sec_exit_earliest,r->sec_exit_latest);
-
-                }
-            }
-
-
-
+        timetabler->genPESPEncoding();
+    } else {
+        if (!timetabler->readJSONFile(argv[1])) {
+            printf("c Error: could not read %s\n", argv[1]);
+            printf("s UNKNOWN\n");
+            exit(_ERROR_);
         }
-    std::cout<<timeV<<std::endl;
-
-
-    printf("Opt\n");
-    std::map<std::string, double >::iterator itpen = instance.route_pen.begin();;
-    PBObjFunction *of = new PBObjFunction();
-    while (itpen != instance.route_pen.end()) {
-            //vec<Lit> litpen;
-            std::string rid = itpen->first.substr(0, itpen->first.find(delimiter));
-            std::string section = itpen->first.substr(itpen->first.find(delimiter) + 1, itpen->first.size());
-            //litpen.push(mkLit(getVariableID("t^" + rid + "^" + section,maxsat_formula)));
-
-            //printf("%f %s \n",itpen->second,("t^" + rid + "^" + section).c_str());
-            of->addProduct(mkLit(getVariableID(
-                    "t^" + rid + "^" + section,maxsat_formula)),ceil(itpen->second));
-            //maxsat_formula->addSoftClause(100,litpen);
-            //litpen.clear();
-            itpen++;
+        timetabler->genEncoding();
+    }
+    if (!loaded) {
+#if MAXSATNID==1
+        if (horizon > 0)
+            printf("c horizon: %d windows widened\n", timetabler->widenHorizon());
+#endif
+        std::string error;
+        if (cached && !FormulaCache::save((const char *) formulaCache, key, timetabler->instance.label,
+                                          timetabler->maxsat_formula, error))
+            printf("c Warning: %s\n", error.c_str());
+    }
+    maxsat_formula = timetabler->maxsat_formula;
+    if (primary)
+        exchangeEncoding();
+
+    if (broker != NULL) {
+        std::string error;
+        if (!brokerClient.connect((const char *) broker, timetabler->encodingHash(), maxsat_formula->nVars(), error)) {
+            printf("c Error: %s\n", error.c_str());
+            printf("s UNKNOWN\n");
+            exit(_ERROR_);
         }
-    if(of->_lits.size()!=0)
-            maxsat_formula->addObjFunction(of);
+        // Answer with the best model so far, as on SIGTERM.
+        brokerClient.onStop = requestStop;
+    }
 }
 #endif
 
@@ -748,7 +791,7 @@ BoolOption printmodel("Open-WBO", "print-model", "Print model.\n", true);
     signal(SIGTERM, SIGINT_exit);
 
 
-    genEncoding(argc,argv);
+    genEncoding(argc, argv, false, true);
 
     if (maxsat_formula->getProblemType() == _UNWEIGHTED_) {
         // Unweighted
@@ -950,7 +993,7 @@ void LinSBPS(int argc, char **argv){
     signal(SIGXCPU, SIGINT_exit);
     signal(SIGTERM, SIGINT_exit);
 
-    genEncoding(argc,argv);
+    genEncoding(argc, argv, false, true);
 
 
 
@@ -1098,7 +1141,7 @@ void loandra(int argc, char **argv){
     signal(SIGXCPU, SIGINT_exit);
     signal(SIGTERM, SIGINT_exit);
 
-    genEncoding(argc,argv);
+    genEncoding(argc, argv, false, true);
 
     if (maxsat_formula->getProblemType() == _UNWEIGHTED_) {
         // Unweighted
@@ -1123,6 +1166,91 @@ void loandra(int argc, char **argv){
 #endif
 
 #if  MAXSATNID==1
+// Solves every scenario of 'file', writing one solution per feasible
+// scenario to data/<label>.<scenario>.out.json.
+int solveScenarios(int argc, char **argv, const char *file, int threads, double timeLimit,
+                   int64_t musPropagations, Server::AlgorithmFactory newAlgorithm) {
+    std::vector<Scenario> scenarios;
+    std::string error;
+    if (!readScenarios(file, scenarios, error)) {
+        printf("c Error: %s\n", error.c_str());
+        printf("s UNKNOWN\n");
+        return _ERROR_;
+    }
+    genEncoding(argc, argv, true);
+    std::vector<ScenarioOutcome> outcomes;
+    ScenarioSolver(*timetabler, newAlgorithm, timeLimit, threads, musPropagations).solve(scenarios, outcomes);
+    for (size_t i = 0; i < scenarios.size(); i++) {
+        const char *status = "UNKNOWN";
+        if (outcomes[i].status == _OPTIMUM_)
+            status = "OPTIMUM";
+        else if (outcomes[i].status == _SATISFIABLE_)
+            status = "SATISFIABLE";
+        else if (outcomes[i].status == _UNSATISFIABLE_)
+            status = "UNSATISFIABLE";
+        else if (outcomes[i].status == _ERROR_)
+            status = "ERROR";
+        printf("c scenario %s: %s", scenarios[i].name.c_str(), status);
+        if (outcomes[i].model.size() > 0)
+            printf(" %" PRIu64, outcomes[i].cost);
+        if (outcomes[i].status == _ERROR_)
+            printf(" %s", outcomes[i].error.c_str());
+        printf("\n");
+        for (const std::string &group: outcomes[i].conflict)
+            printf("c   conflict: %s\n", group.c_str());
+        for (const std::string &group: outcomes[i].relaxed)
+            printf("c   relaxed: %s\n", group.c_str());
+        if (outcomes[i].model.size() > 0) {
+            vec<lbool> model;
+            for (lbool v: outcomes[i].model)
+                model.push(v);
+            timetabler->decodeModel(model);
+            timetabler->outputJSONFile(scenarios[i].name);
+        }
+    }
+    return 0;
+}
+
+// Runs the worker command lines of 'file' (one per line, '#' starts a
+// comment) as a portfolio on the instance, writing the best solution found.
+int runPortfolio(int argc, char **argv, const char *file, int port, const char *address, double timeLimit,
+                 int sync) {
+    std::ifstream in(file);
+    if (!in) {
+        printf("c Error: cannot read %s\n", file);
+        printf("s UNKNOWN\n");
+        return _ERROR_;
+    }
+    std::vector<std::string> commands;
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") != std::string::npos)
+            commands.push_back(line);
+    }
+    if (commands.empty()) {
+        printf("c Error: no worker in %s\n", file);
+        printf("s UNKNOWN\n");
+        return _ERROR_;
+    }
+    genEncoding(argc, argv);
+    Portfolio portfolio(*timetabler, argv[1], timeLimit, port, sync, address != NULL ? address : "");
+    StatusCode status = portfolio.run(commands);
+    if (portfolio.model.size() > 0) {
+        timetabler->decodeModel(portfolio.model);
+        timetabler->outputJSONFile();
+    }
+    if (status == _OPTIMUM_)
+        printf("s OPTIMUM FOUND\n");
+    else if (status == _UNSATISFIABLE_)
+        printf("s UNSATISFIABLE\n");
+    else if (portfolio.model.size() > 0)
+        printf("s SATISFIABLE\n");
+    else
+        printf("s UNKNOWN\n");
+    return status == _ERROR_ ? _ERROR_ : 0;
+}
+
 void tt(int argc, char **argv) {
     BoolOption printmodel("Open-WBO", "print-model", "Print model.\n", true);
     BoolOption optC1T("Timetabler", "opt-allocation",
@@ -1231,6 +1359,10 @@ void tt(int argc, char **argv) {
 
     BoolOption local("Incomplete", "local", "Local limit on the number of conflicts.\n", false);
 
+    IntOption sat_threads("Open-WBO", "sat-threads",
+                          "Threads of the hard SAT calls, sharing their learnt clauses.\n", 1,
+                          IntRange(1, 256));
+
     BoolOption polConservative("TorcOpenWbo", "conservative", "Apply conservative polarity heuristic?\n", true);
     BoolOption conservativeUseAllVars("TorcOpenWbo", "conservative_use_all_vars",
                                       "Re-use the polarity of all the variables within the conservative approach (or, otherwise, only the initial once)?\n",
@@ -1244,11 +1376,78 @@ void tt(int argc, char **argv) {
 
     IntOption targetVarsBumpMaxRandVal("TorcOpenWbo", "target_vars_bump_max_rand_val",
                                        "Maximal random bump factor\n", 552);
+    IntOption seed("TorcOpenWbo", "seed",
+                   "Seed of the random bumps and decisions of each solver, reproducible across threads\n"
+                   "(0=process-wide random bumps).\n", 0, IntRange(0, INT_MAX));
+
+    StringOption server("Timetabler", "server",
+                        "Serve requests on a Unix socket (path) or on stdin/stdout (-).\n", NULL);
+    IntOption server_time_lim("Timetabler", "server-time-lim",
+                              "Default wall-clock limit of a server request in seconds (0=none).\n", 0,
+                              IntRange(0, INT_MAX));
+    StringOption scenarios("Timetabler", "scenarios",
+                           "Solve the what-if scenarios of a JSON file on one encoding of the instance.\n", NULL);
+    IntOption scenario_threads("Timetabler", "scenario-threads",
+                               "Threads solving scenarios.\n", 1, IntRange(1, INT_MAX));
+    IntOption scenario_time_lim("Timetabler", "scenario-time-lim",
+                                "Wall-clock limit of each scenario in seconds (0=none).\n", 0,
+                                IntRange(0, INT_MAX));
+    StringOption checkpoint("Timetabler", "checkpoint",
+                            "Save the state of the search to this file, to be resumed with -resume.\n", NULL);
+    IntOption checkpoint_interval("Timetabler", "checkpoint-interval",
+                                  "Seconds between two checkpoints.\n", 60, IntRange(0, INT_MAX));
+    StringOption resume("Timetabler", "resume",
+                        "Resume the search from a checkpoint of the same instance and -opt-time.\n", NULL);
+    StringOption clause_cache("Timetabler", "clause-cache",
+                              "Reuse the learnt clauses and cores over route sections of related instances\n"
+                              "kept in this file, and add those of this run.\n", NULL);
+    StringOption portfolio("Timetabler", "portfolio",
+                           "Run the worker command lines of this file as a portfolio sharing incumbents.\n", NULL);
+    IntOption portfolio_port("Timetabler", "portfolio-port",
+                             "TCP port for remote portfolio workers (0=none).\n", 0, IntRange(0, 65535));
+    StringOption portfolio_address("Timetabler", "portfolio-address",
+                                   "IPv4 address the TCP port of -portfolio-port listens on (default: 127.0.0.1;\n"
+                                   "0.0.0.0 for every interface).\n", NULL);
+    IntOption portfolio_time_lim("Timetabler", "portfolio-time-lim",
+                                 "Wall-clock limit of the portfolio in seconds (0=none).\n", 0,
+                                 IntRange(0, INT_MAX));
+    IntOption portfolio_sync("Timetabler", "portfolio-sync",
+                             "Deterministic portfolio: conflicts between two exchanges of incumbents\n"
+                             "(0=exchange them as soon as they are found).\n", 0, IntRange(0, INT_MAX));
+    IntOption lb_conflicts("Timetabler", "lb-conflicts",
+                           "Conflicts of the SAT calls looking for disjoint cores before the search\n"
+                           "(0=lower bound of the section requirements only, none with -relax or -diagnose).\n", 10000, IntRange(0, INT_MAX));
+    DoubleOption gap("Timetabler", "gap",
+                     "Stop when the cost is within this percentage of the lower bound (-1=never).\n", -1,
+                     DoubleRange(-1, true, 100, true));
+    BoolOption diagnose("Timetabler", "diagnose",
+                        "Check the instance with every requirement, train and resource active, and\n"
+                        "explain an infeasible one by a minimal set of them.\n", false);
+    IntOption mus_propagations("Timetabler", "mus-propagations",
+                               "Propagations of the explanation of an infeasible instance or scenario\n"
+                               "(-1=no limit).\n", ScenarioSolver::defaultMUSPropagations, IntRange(-1, INT_MAX));
+    IntOption horizon_opt("Timetabler", "horizon",
+                          "Adaptive horizon: entry windows first end this many seconds after the latest\n"
+                          "entry, and are widened when they make the instance infeasible (0=off).\n", 0,
+                          IntRange(0, INT_MAX));
+    IntOption k_solutions("Timetabler", "k-solutions",
+                          "Write this many plans: the best one found, then alternatives within\n"
+                          "-k-tolerance of its cost.\n", 1, IntRange(1, INT_MAX));
+    DoubleOption k_tolerance("Timetabler", "k-tolerance",
+                             "Percentage of the best cost an alternative plan may cost more.\n", 0,
+                             DoubleRange(0, true, HUGE_VAL, true));
+    IntOption k_distance("Timetabler", "k-distance",
+                         "Route section variables in which two plans differ, at least.\n", 1,
+                         IntRange(1, INT_MAX));
+    DoubleOption k_time("Timetabler", "k-time",
+                        "Wall-clock limit of the alternative plans in seconds (0=none).\n", 0,
+                        DoubleRange(0, true, HUGE_VAL, true));
 
 
 
     parseOptions(argc, argv, true);
     option=(int) optionT;
+    horizon = horizon_opt;
 
 
     if ((int) num_tests) {
@@ -1271,102 +1470,149 @@ void tt(int argc, char **argv) {
     Torc::Instance()->SetTargetVarsBumpVal(targetVarsBumpVal);
     Torc::Instance()->SetBumpRelWeights(targetVarsBumpRelWeights);
     Torc::Instance()->SetTargetBumpMaxRandVal(targetVarsBumpMaxRandVal);
+    Torc::Instance()->SetSeed(seed);
 
 
-    Statistics rounding_statistic =
-            static_cast<Statistics>((int) rounding_strategy);
-
-    switch ((int) algorithm) {
-        case _ALGORITHM_WBO_:
-            S = new WBO(verbosity, weight, symmetry, symmetry_lim);
-            break;
-
-        case _ALGORITHM_LINEAR_SU_:
-            if ((int) (cluster_algorithm) == 1) {
-                S = new LinearSUMod(verbosity, bmo, cardinality, pb,
-                                    ClusterAlg::_DIVISIVE_, rounding_statistic,
-                                    (int) (num_clusters));
-            } else {
-                S = new LinearSU(verbosity, bmo, cardinality, pb);
-            }
-            break;
-
-        case _ALGORITHM_PART_MSU3_:
-            S = new PartMSU3(verbosity, partition_strategy, graph_type, cardinality);
-            break;
-
-        case _ALGORITHM_MSU3_:
-            S = new MSU3(verbosity);
-            break;
-
-        case _ALGORITHM_LSU_CLUSTER_:
-            S = new LinearSUClustering(verbosity, bmo, cardinality, pb,
-                                       ClusterAlg::_DIVISIVE_, rounding_statistic,
-                                       (int) (num_clusters));
-            break;
-
-        case _ALGORITHM_LSU_MRSBEAVER_:
-            S = new OBV(verbosity, cardinality, num_conflicts, num_iterations, local);
-            break;
-
-        case _ALGORITHM_LSU_MCS_:
-            S = new BLS(verbosity, cardinality, num_conflicts, num_iterations, local);
-            break;
+    if ((int) algorithm > _ALGORITHM_LSU_MCS_) {
+        printf("c Error: Invalid MaxSAT algorithm.\n");
+        printf("s UNKNOWN\n");
+        exit(_ERROR_);
+    }
+    // Only the timing model of -delays can make a clipped window infeasible
+    if (horizon > 0 && (!delays || option != 2)) {
+        printf("c Error: -horizon needs -delays and -opt-time=2.\n");
+        printf("s UNKNOWN\n");
+        exit(_ERROR_);
+    }
 
-        case _ALGORITHM_OLL_:
-            if ((int) (cluster_algorithm) == 1) {
-                S = new OLLMod(verbosity, cardinality, ClusterAlg::_DIVISIVE_,
-                               rounding_statistic, (int) (num_clusters));
-            } else {
-                S = new OLL(verbosity, cardinality);
-            }
-            break;
+    libtimetabler::Options options;
+    options.optTime = option;
+    options.algorithm = algorithm;
+    options.verbosity = verbosity;
+    options.bmo = bmo;
+    options.cardinality = cardinality;
+    options.pb = pb;
+    options.weightStrategy = weight;
+    options.symmetry = symmetry;
+    options.symmetryLimit = symmetry_lim;
+    options.clusterAlgorithm = cluster_algorithm;
+    options.numClusters = num_clusters;
+    options.roundingStrategy = rounding_strategy;
+    options.partitionStrategy = partition_strategy;
+    options.graphType = graph_type;
+    options.conflicts = num_conflicts;
+    options.iterations = num_iterations;
+    options.local = local;
+    options.satThreads = sat_threads;
+    options.lbConflicts = lb_conflicts;
+    options.gap = gap;
+    options.relax = relax;
+    options.delays = delays;
+    options.diagnose = diagnose;
+    options.musPropagations = mus_propagations;
+    options.horizon = horizon;
+    options.timeLimit = server_time_lim;
+    // Called once per request in server mode.
+    Server::AlgorithmFactory newAlgorithm = [options](MaxSATFormula *formula) {
+        return libtimetabler::newAlgorithm(options, formula);
+    };
+
+    sigset_t stops;
+    sigemptyset(&stops);
+    sigaddset(&stops, SIGXCPU);
+    sigaddset(&stops, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stops, NULL);
+    std::thread(waitForStop, stops).detach();
+
+    if (server != NULL) {
+        Server srv(options, newAlgorithm);
+        std::exit(strcmp(server, "-") == 0 ? srv.serveStdin() : srv.serveSocket(server));
+    }
 
-        case _ALGORITHM_BEST_:
-            break;
+    if (scenarios != NULL)
+        std::exit(solveScenarios(argc, argv, scenarios, scenario_threads, scenario_time_lim,
+                                 mus_propagations, newAlgorithm));
 
-        default:
-            printf("c Error: Invalid MaxSAT algorithm.\n");
+    if (portfolio != NULL) {
+        if (portfolio_sync > 0 && portfolio_port > 0) {
+            printf("c Error: a deterministic portfolio has no remote workers.\n");
             printf("s UNKNOWN\n");
             exit(_ERROR_);
+        }
+        std::exit(runPortfolio(argc, argv, portfolio, portfolio_port, portfolio_address, portfolio_time_lim,
+                               portfolio_sync));
     }
 
-
-    signal(SIGXCPU, SIGINT_exit);
-    signal(SIGTERM, SIGINT_exit);
-
-    genEncoding(argc,argv);
+    genEncoding(argc, argv, diagnose, true);
     std::cout<<maxsat_formula->nHard()<<std::endl;
 
-    if (maxsat_formula->getProblemType() == _UNWEIGHTED_)
-        S = new OLL(verbosity, cardinality);
-    else {
-
-        if ((int) (cluster_algorithm) == 1) {
-            switch ((int) algorithm) {
-                case _ALGORITHM_LINEAR_SU_:
-                    static_cast<LinearSUMod *>(S)->initializeCluster();
-                    break;
-                case _ALGORITHM_OLL_:
-                    static_cast<OLLMod *>(S)->initializeCluster();
-                    break;
-                case _ALGORITHM_LSU_CLUSTER_:
-                    static_cast<LinearSUClustering *>(S)->initializeCluster();
-                    break;
-            }
+    S = newAlgorithm(maxsat_formula);
+    timetabler->S = S;
+
+    if (diagnose) {
+        std::vector<std::string> groups;
+        bool minimal;
+        lbool res = timetabler->diagnose(mus_propagations, groups, minimal);
+        printf("c diagnosis: %s\n", res == l_True ? "feasible" : res == l_False ? "infeasible" : "unknown");
+        for (const std::string &group: groups)
+            printf("c   conflict: %s\n", group.c_str());
+        if (res == l_False && !minimal)
+            printf("c   (out of propagations, some of these may not be needed)\n");
+        // Otherwise the relaxed search gives the least-bad plan.
+        if (res == l_False && !relax) {
+            printf("s UNSATISFIABLE\n");
+            exit(_UNSATISFIABLE_);
         }
     }
 
-
+    // Options the phase of a checkpoint depends on
+    std::string config = "algorithm=" + std::to_string((int) algorithm) +
+                         " bmo=" + std::to_string((int) (bool) bmo) +
+                         " cardinality=" + std::to_string((int) cardinality) +
+                         " pb=" + std::to_string((int) pb) +
+                         " ca=" + std::to_string((int) cluster_algorithm) +
+                         " c=" + std::to_string((int) num_clusters) +
+                         " rs=" + std::to_string((int) rounding_strategy);
+    if (resume != NULL) {
+        std::string error;
+        if (!timetabler->resume((const char *) resume, config, error)) {
+            printf("c Error: %s\n", error.c_str());
+            printf("s UNKNOWN\n");
+            exit(_ERROR_);
+        }
+        const Checkpoint &state = timetabler->checkpoint;
+        printf("c resumed: %d learnt clauses, LB %" PRIu64, (int) state.learnts.size(), state.lb);
+        if (!state.model.empty())
+            printf(", UB %" PRIu64, state.ub);
+        printf("\n");
+    }
+    if (checkpoint != NULL)
+        timetabler->enableCheckpoints((const char *) checkpoint, checkpoint_interval, config);
+    if (clause_cache != NULL) {
+        std::string error;
+        clauseCacheFile = (const char *) clause_cache;
+        if (!clauseCache.load(clauseCacheFile, error)) {
+            printf("c Error: %s\n", error.c_str());
+            printf("s UNKNOWN\n");
+            exit(_ERROR_);
+        }
+        int cached = clauseCache.size();
+        int injected = timetabler->useClauseCache(&clauseCache);
+        printf("c clause cache: %d of %d clauses hold\n", injected, cached);
+    }
+    if (brokerClient.connected())
+        timetabler->useBroker(&brokerClient);
+    printf("c LB %" PRIu64 "\n", timetabler->computeLowerBound(lb_conflicts));
+    if (gap >= 0)
+        timetabler->stopAtGap(gap / 100);
+    kSolutions = k_solutions;
+    kTolerance = k_tolerance / 100;
+    kDistance = k_distance;
+    kTime = k_time;
 }
 #endif
 
 #if  MAXSATNID<5
-void newVar(std::string name,MaxSATFormula*maxsat_formula){
-
-}
-
-
 void printSolverStats(MaxSATFormula*maxsat_formula,double initial_time){
     printf("c |                                                                "
                    "                                       |\n");
@@ -1421,126 +1667,10 @@ void printSolverStats(MaxSATFormula*maxsat_formula,double initial_time){
 
 }
 
-// Get the variable identifier corresponding to a given name. If the
-// variable does not exist, a new identifier is created.
-int getVariableID(std::string varName,MaxSATFormula*maxsat_formula) {
-    char *cstr = new char[varName.length() + 1];
-    strcpy(cstr, varName.c_str());
-    int id = maxsat_formula->varID(cstr);
-    if (id == var_Undef)
-        id = maxsat_formula->newVarName(cstr);
-    delete[] cstr;
-    return id;
-}
 
 #endif
 
 
-Instance readPESPInstance(char* local){
-    Instance i;
-    std::ifstream infile(local);
-
-    int N, O, T, L, U, W;
-    std::string line;
-    while (std::getline(infile, line)) {
-        std::cout<<line<<std::endl;
-            std::istringstream iss(line);
-            if (!(iss >> N >> O >> T >> L >> U >> W )){
-                continue;
-            }
-        //std::cout<<  N << " "<< O << " "<< T << " "<< L << " " <<U << " " <<W<< std::endl;
-
-    }
-    return i;
-
-
-    }
-
-void outputJSONFile(Instance instance) {
-    StringBuffer s;
-
-    PrettyWriter<StringBuffer> writer(s);
-    writer.StartObject();               // Between StartObject()/EndObject(),
-    writer.Key("problem_instance_label");                // output a key,
-    writer.String(instance.label.c_str());             // follow by a value.
-    writer.Key("problem_instance_hash");                // output a key,
-    writer.Int(instance.hash);             // follow by a value.
-    writer.Key("hash");                // output a key,
-    writer.Int(42);             // follow by a value.
-    writer.Key("train_runs");
-    writer.StartArray();
-    std::map<std::string,std::map<int,train_run_sections*>> ::iterator it = instance.results.begin();
-    while (it != instance.results.end()) {
-        writer.StartObject();
-        writer.Key("service_intention_id");
-        writer.String(it->first.c_str());
-        writer.Key("train_run_sections");
-        writer.StartArray();
-        std::map<int,train_run_sections*>::iterator it1 = it->second.begin();
-        int j=1;
-        while (it1 != it->second.end()) {
-            writer.StartObject();
-            writer.Key("entry_time");
-            writer.String(it1->second->entry_time.c_str());
-            writer.Key("exit_time");
-            writer.String(it1->second->exit_time.c_str());
-            writer.Key("route");
-            writer.String(it1->second->route.c_str());
-
-            writer.Key("route_section_id");
-            writer.String(it1->second->route_section_id.c_str());
-
-            writer.Key("sequence_number");
-            writer.Int(j);
-
-            writer.Key("route_path");
-            writer.String(it1->second->route_path_str.c_str());
-
-            writer.Key("section_requirement");
-            if(it1->second->section_requirement.size()==0)
-                writer.Null();
-            else
-                writer.String(it1->second->section_requirement.c_str());
-
-
-            writer.EndObject();
-            it1++;
-            j++;
-
-
-        }
-        it++;
-        writer.EndArray();
-        writer.EndObject();
-
-
-
-    }
-
-
-
-    writer.EndArray();
-
-    writer.EndObject();
-
-
-
-
-
-
-
-    //Solution to file
-
-    ofstream myfile;
-    myfile.open ("data/"+instance.label+".out.json");
-    myfile << s.GetString();
-    myfile.close();
-
-
-
-
-}
-
 Instance readOutputJSONFile(char* local) {
     ifstream ifs(local);
     IStreamWrapper isw(ifs);
@@ -1606,371 +1736,6 @@ Instance readOutputJSONFile(char* local) {
 
 }
 
-Instance readJSONFile(char* local) {
-
-    ifstream ifs(local);
-    IStreamWrapper isw(ifs);
-    Document d;
-    d.ParseStream(isw);
-
-    Instance Instance;
-
-    Instance.hash=d["hash"].GetInt();
-    Instance.label=d["label"].GetString();
-    std::vector<Train> tt;
-    std::map<std::string, double > route_pen;
-    for (int i = 0; i < d["service_intentions"].GetArray().Size(); ++i) {
-        Train train;
-        if(d["service_intentions"].GetArray()[i]["id"].IsInt())
-            train.id=std::to_string(d["service_intentions"].GetArray()[i]["id"].GetInt());
-        else
-            train.id=d["service_intentions"].GetArray()[i]["id"].GetString();
-
-        if(d["service_intentions"].GetArray()[i]["route"].IsInt())
-            train.route=std::to_string(d["service_intentions"].GetArray()[i]["route"].GetInt());
-        else
-            train.route=d["service_intentions"].GetArray()[i]["route"].GetString();
-        std::vector<Requirement*> re;
-
-        for (int j = 0; j <d["service_intentions"].GetArray()[i]["section_requirements"].GetArray().Size() ; ++j) {
-            string id="",delay="";
-            string entry_ea="",exit_earliest="",type="",min_stopping_time="",marker="",exit_latest="",entry_latest="";
-            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("entry_latest"))
-                entry_latest=d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["entry_latest"].GetString();
-            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("exit_latest"))
-                exit_latest=d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["exit_latest"].GetString();
-
-            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("entry_earliest"))
-                entry_ea=d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["entry_earliest"].GetString();
-            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("exit_earliest"))
-                exit_earliest=d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["exit_earliest"].GetString();
-
-            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("section_marker"))
-                marker=d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["section_marker"].GetString();
-            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("type"))
-                type=d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["type"].GetString();
-
-
-            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("min_stopping_time"))
-                min_stopping_time=d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["min_stopping_time"].GetString();
-            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("sequence_number")){
-               if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["sequence_number"].IsInt())
-                   id=std::to_string(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["sequence_number"].GetInt());
-                else
-                   id = d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["sequence_number"].GetString();
-
-
-            }
-
-            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("entry_delay_weight")) {
-                if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["entry_delay_weight"].IsInt())
-                    delay=std::to_string(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["entry_delay_weight"].GetInt());
-                else
-                    delay=std::to_string(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["entry_delay_weight"].GetFloat());
-
-            }
-
-            list<connection> clist;
-
-            if(d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j].HasMember("connections")){
-                if(!d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["connections"].IsNull()){
-                    for (int k = 0; k < d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["connections"].GetArray().Size(); ++k) {
-                        if(!d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["connections"].GetArray()[k].IsNull()) {
-                            connection c = connection(
-                                    d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["connections"].GetArray()[k]["onto_service_intention"].GetInt(),
-                                    d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["connections"].GetArray()[k]["onto_section_marker"].GetString(),
-                                    d["service_intentions"].GetArray()[i]["section_requirements"].GetArray()[j]["connections"].GetArray()[k]["min_connection_time"].GetString());
-                            clist.push_back(c);
-                        }
-
-                    }
-                }
-            }
-
-
-
-            if(id.compare("")!=0) {
-                Requirement *r = new Requirement(id,
-                                            marker,
-                                            type,
-                                            min_stopping_time,
-                                            entry_ea,
-                                            delay,
-                                            exit_earliest,entry_latest,exit_latest);
-                r->connections = clist;
-                //printf("Marker!: %s \n",marker.c_str());
-                //std::cout <<"now "<< *r << std::endl;
-                //r->toString();
-                if(minV > r->sec_entry_earliest&&r->sec_entry_earliest !=-1)
-                    minV=r->sec_entry_earliest;
-                if(maxV < r->sec_exit_latest &&r->sec_exit_latest !=-1)
-                    maxV=r->sec_exit_latest;
-                if(diffV<(minV-maxV))
-                    diffV=(minV-maxV);
-                if(re.size()>0){
-
-                    //std::cout <<"old "<< *re[re.size()-1] << std::endl;
-                    if(re[re.size()-1]->exit_latest.compare("")==0){
-                        if(r->entry_earliest.compare("")!=0){
-                            re[re.size()-1]->sec_exit_latest=r->sec_entry_earliest;//+re[re.size()-1]->min_stopping_time;
-                            //printf("earl  %d\n",re[re.size()-1]->sec_exit_latest);
-                        } else if(r->exit_latest.compare("")!=0){
-                            re[re.size()-1]->sec_exit_latest=r->sec_exit_latest;//+re[re.size()-1]->min_stopping_time;
-                            //printf("exit %d\n",re[re.size()-1]->sec_exit_latest);
-                        } else {
-                            re[re.size()-1]->sec_exit_latest=r->sec_exit_earliest;//+re[re.size()-1]->min_stopping_time;
-                            //printf("exit %d\n",re[re.size()-1]->sec_exit_earliest);
-                        }
-                    }
-                    if(r->entry_earliest.compare("")==0){
-                        if(re[re.size()-1]->exit_latest.compare("")!=0){
-                            r->sec_entry_earliest=re[re.size()-1]->sec_exit_latest;//+re[re.size()-1]->min_stopping_time;
-                            //printf("exit ow %d\n",r->sec_entry_earliest);
-                        } else  if(re[re.size()-1]->sec_entry_earliest!=-1){
-                            r->sec_entry_earliest=re[re.size()-1]->sec_entry_earliest;//+re[re.size()-1]->min_stopping_time;
-                            //printf("earl ow %d\n",r->sec_entry_earliest);
-                        } else {
-                            printf("shit\n");
-                        }
-                    }
-
-
-                }
-                re.push_back(r);
-
-            }
-
-            //if(std::stoi(id)==d["service_intentions"].GetArray()[i]["section_requirements"].GetArray().Size())
-              //  printf("exa: %s l: %s\n",exit_earliest.c_str(),exit_latest.c_str());
-
-
-        }
-        train.t=re;
-
-
-        tt.push_back(train);
-    }
-
-
-    Instance.train=tt;
-    std::map<std::string,Route> rr;
-    std::map<std::string, std::map<int,std::vector<route_section*>>> end1;
-    std::map<std::string,std::vector<route_section*>> entryMap;
-    std::map<std::string,std::vector<route_section*>> exitMap;
-    std::map<std::string,std::vector<route_section*>> markerMap;
-
-    std::map<std::string,std::map<int,route_section*>> secMap;
-
-
-    for (int m = 0; m < d["routes"].GetArray().Size(); ++m) {
-        int nSeq=0;
-       Route r;
-        if(d["routes"].GetArray()[m]["id"].IsInt())
-            r.id=std::to_string(d["routes"].GetArray()[m]["id"].GetInt());
-
-        else
-            r.id=d["routes"].GetArray()[m]["id"].GetString();
-        std::list<route_path> rpl;
-        route_path rp;
-
-        for (int i = 0; i < d["routes"].GetArray()[m]["route_paths"].GetArray().Size(); ++i) {
-            if(d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["id"].IsInt())
-                rp.id=std::to_string(d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["id"].GetInt());
-            else
-                rp.id=d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["id"].GetString();
-            std::list<route_section*> rsl;
-            route_section *rs= new route_section();
-            route_section *rs1= new route_section();
-
-
-            for (int j = 0; j < d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"].GetArray().Size(); j++) {
-                nSeq++;
-                size++;
-                rs->sequence_number = d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["sequence_number"].GetInt();
-                std::list<std::string> temp;
-                if (d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j].HasMember(
-                        "route_alternative_marker_at_entry")) {
-                    for (int k = 0; k <
-                                    d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["route_alternative_marker_at_entry"].GetArray().Size(); ++k) {
-                        std::string e =d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["route_alternative_marker_at_entry"].GetArray()[k].GetString();
-                        temp.push_front(e);
-                    std::string c = e +"^"+ r.id;
-//                            printf("Entry: %s s %d\n",c.c_str(),rs->sequence_number);
-                        if(entryMap.find(c)!=entryMap.end()){
-                            entryMap[c].push_back(rs);
-                        } else {
-                            std::vector<route_section*> rsV;
-                            rsV.push_back(rs);
-                            entryMap.insert(std::pair<std::string,std::vector<route_section*>>(c,rsV));
-                        }
-                    }
-                }
-
-                rs->route_alternative_marker_at_entry = temp;
-                temp.clear();
-                if (d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j].HasMember(
-                        "route_alternative_marker_at_exit")) {
-                    for (int k = 0; k <
-                                    d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["route_alternative_marker_at_exit"].GetArray().Size(); ++k) {
-                        std::string e =d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["route_alternative_marker_at_exit"].GetArray()[k].GetString();
-                        temp.push_front(e);
-                        std::string c = e +"^"+ r.id;
-//                            printf("Exit: %s s %d\n",c.c_str(),rs->sequence_number);
-                        if(exitMap.find(c)!=exitMap.end()){
-                            exitMap[c].push_back(rs);
-                        } else {
-                            std::vector<route_section*> rsV;
-                            rsV.push_back(rs);
-                            exitMap.insert(std::pair<std::string,std::vector<route_section*>>(c,rsV));
-                        }
-                    }
-
-                }
-                rs->route_alternative_marker_at_exit = temp;
-                temp.clear();
-                if (d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j].HasMember(
-                        "section_marker")) {
-                    for (int k = 0; k <
-                                    d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["section_marker"].GetArray().Size(); ++k) {
-                        std::string e = d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["section_marker"].GetArray()[k].GetString();
-                        temp.push_front(e);
-                        std::string c = r.id +"^"+e;
-//                        printf("Marker: %s s %d\n",c.c_str(),rs->sequence_number);
-                        if(markerMap.find(c)!=exitMap.end()){
-                            markerMap[c].push_back(rs);
-                        } else {
-                            std::vector<route_section*> rsV;
-                            rsV.push_back(rs);
-                            markerMap.insert(std::pair<std::string,std::vector<route_section*>>(c,rsV));
-                        }
-
-
-                    }
-                }
-                rs->section_marke = temp;
-                if (d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j].HasMember(
-                        "resource_occupations")) {
-                    std::list<Resource> tempR;
-                    for (int k = 0; k <
-                                    d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["resource_occupations"].GetArray().Size(); ++k) {
-                        Resource r;
-                        if (d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["resource_occupations"].GetArray()[k]["occupation_direction"].IsString())
-                            r = Resource(
-                                    d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["resource_occupations"].GetArray()[k]["resource"].GetString(),
-                                    d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["resource_occupations"].GetArray()[k]["occupation_direction"].GetString());
-                        else
-                            r = Resource(
-                                    d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["resource_occupations"].GetArray()[k]["resource"].GetString());
-
-                        tempR.push_front(r);
-                    }
-                    rs->resource_occupations = tempR;
-                } else {
-                    std::list<Resource> tempR;
-                    rs->resource_occupations = tempR;
-                }
-                if(d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j].HasMember("penalty")) {
-                    if (!d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["penalty"].IsNull())
-                        rs->penalty = d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["penalty"].GetDouble();
-                    else
-                        rs->penalty = 0;
-                } else
-                    rs->penalty = 0;
-                if(rs->penalty != 0)
-                    route_pen.insert(std::pair<std::string, double>(r.id+"^"+std::to_string(rs->sequence_number),rs->penalty));
-                rs->route_pathName=rp.id;
-                rs->starting_point = d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["starting_point"].GetString();
-                rs->minimum_running_time = d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["minimum_running_time"].GetString();
-                rs->minimum_running_time = rs->minimum_running_time.substr(2, 2);
-                rs->ending_point = d["routes"].GetArray()[m]["route_paths"].GetArray()[i]["route_sections"][j]["ending_point"].GetString();
-                if (j > 0) {
-                    //printf("train: %s origin %d dest %d\n",r.id.c_str(),rs1->sequence_number,rs->sequence_number);
-                    auto it = end1.find(r.id);
-                    if (it == end1.end()) {
-                        std::map<int, std::vector < route_section * >> mapEnd;
-                        std::vector<route_section*> t;
-                        t.push_back(rs);
-                        t.push_back(rs1);
-                        mapEnd.insert(std::pair<int, std::vector < route_section * >>(rs->sequence_number,t));
-                        end1.insert(std::pair < std::string, std::map < int,
-                                    std::vector < route_section * >> > (r.id, mapEnd));
-                    } else {
-                        auto it1 = it->second.find(rs->sequence_number);
-                        if (it1 == it->second.end()) {
-                            std::vector<route_section*> t;
-                            t.push_back(rs);
-                            t.push_back(rs1);
-                            it->second.insert(std::pair<int, std::vector < route_section * >>(rs->sequence_number,t));
-                        } else {
-                            it1->second.push_back(rs1);
-                        }
-                    }
-                }
-                if(Instance.pathMap.find(r.id)!=Instance.pathMap.end()){
-                    if(Instance.pathMap[r.id].find(rp.id)!=Instance.pathMap[r.id].end()){
-                        if(Instance.pathMap[r.id][rp.id].find(rs->sequence_number)==Instance.pathMap[r.id][rp.id].end()){
-                            Instance.pathMap[r.id][rp.id].insert(std::pair<int,route_section*>(rs->sequence_number,rs));
-                        }
-                    } else{
-                        std::map<int,route_section*> tempM; tempM.insert(std::pair<int,route_section*>(rs->sequence_number,rs));
-                        Instance.pathMap[r.id].insert(std::pair<std::string,std::map<int,route_section*>>(rp.id, tempM));
-
-                    }
-                } else{
-                    std::map<int,route_section*> tempM; tempM.insert(std::pair<int,route_section*>(rs->sequence_number,rs));
-                    std::map<std::string,std::map<int,route_section*>> tempM1; tempM1.insert(std::pair<std::string,std::map<int,route_section*>>(rp.id,tempM));
-                    Instance.pathMap.insert(std::pair<std::string,std::map<std::string,std::map<int,route_section*>>>(r.id, tempM1));
-
-                }
-
-                rs1=rs;
-
-                if(secMap.find(r.id)!=secMap.end()) {
-                    if (secMap[r.id].find(rs->sequence_number) == secMap[r.id].end()) {
-                        secMap[r.id].insert(std::pair<int,route_section*>(rs->sequence_number,rs));
-                    } else{
-                        printf("OPS: This should not happen: line 959\n");
-                        std::exit(1);
-                    }
-
-                } else {
-                    std::map<int,route_section*> mapT;
-                    mapT.insert(std::pair<int,route_section*>(rs->sequence_number,rs));
-                    secMap.insert(std::pair<std::string,std::map<int,route_section*>>(r.id,mapT));
-                }
-                rsl.push_front(rs1);
-                rs= new route_section();
-
-
-            }
-
-            rp.route_sections=rsl;
-            rpl.push_front(rp);
-
-        }
-        r.route_paths=rpl;
-        r.totalSeq=nSeq;
-        rr.insert(std::pair<std::string,Route>(r.id,r));
-    }
-    Instance.route=rr;
-    Instance.exitMap=exitMap;
-    Instance.entryMap=entryMap;
-    Instance.markerMap=markerMap;
-    Instance.route_pen=route_pen;
-    Instance.sectionMap=secMap;
-    Instance.end=end1;
-
-    std::list<Resource> reso;
-    for (int l = 0; l < d["resources"].GetArray().Size(); ++l) {
-      Resource resource = Resource(d["resources"].GetArray()[l]["id"].GetString(),d["resources"].GetArray()[l]["release_time"].GetString(),d["resources"].GetArray()[l]["following_allowed"].GetBool());
-      reso.push_front(resource);
-
-    }
-    Instance.resource=reso;
-    Instance.maxBandabweichung=d["parameters"].GetObject()["maxBandabweichung"].GetString();
-
-    return Instance;
-}
 
 
 
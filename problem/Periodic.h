@@ -0,0 +1,30 @@
+//
+// Periodic event scheduling problem (PESP) instances, see PESPlib.
+//
+
+#ifndef TRAIN_SCHEDULE_OPTIMISATION_PERIODIC_H
+#define TRAIN_SCHEDULE_OPTIMISATION_PERIODIC_H
+
+#include <string>
+#include <vector>
+
+// Activity of the event-activity network: the periodic tension
+// (time[to] - time[from] - lower) mod period must be at most
+// upper - lower, and costs 'weight' per time unit of lower + tension.
+struct PeriodicActivity {
+    std::string id;
+    int from, to;// indices in PeriodicInstance::events
+    int lower, upper;
+    int weight;
+};
+
+struct PeriodicInstance {
+    std::string label;
+    int period = 0;
+    std::vector<std::string> events;// ids, in order of appearance
+    std::vector<PeriodicActivity> activities;
+    // Event times of the last decoded model, in [0, period).
+    std::vector<int> times;
+};
+
+#endif //TRAIN_SCHEDULE_OPTIMISATION_PERIODIC_H
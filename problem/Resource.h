@@ -21,6 +21,11 @@ public:
     }
     Resource(){
     }
+
+    const std::string &getId() const {
+        return id;
+    }
+
     friend std::ostream &operator<<(std::ostream &os, const Resource &Resource) {
         os << "id: " << Resource.id << " release_time: " << Resource.release_time << " following_allowed: "
            << Resource.following_allowed;
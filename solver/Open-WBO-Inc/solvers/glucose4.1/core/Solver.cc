@@ -454,7 +454,7 @@ bool Solver::addClause_(vec <Lit> &ps) {
         return ok = false;
     } else if(ps.size() == 1) {
         uncheckedEnqueue(ps[0]);
-        return  (propagate() == CRef_Undef);
+        return ok = (propagate() == CRef_Undef);
     } else {
         CRef cr = ca.alloc(ps, false);
         clauses.push(cr);
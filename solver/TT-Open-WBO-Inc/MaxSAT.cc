@@ -58,12 +58,25 @@ Solver *MaxSAT::newSATSolver() {
 #ifdef SIMP
   NSPACE::SimpSolver *S = new NSPACE::SimpSolver();
 #else
-  Solver *S = new Solver();
+  Solver *S;
+  if (satThreads > 1) {
+    NSPACE::ParallelSolver *P = new NSPACE::ParallelSolver();
+    P->threads = satThreads;
+    // A seed asks for reproducible runs (the workers of -portfolio-sync get one).
+    if (Torc::Instance()->GetSeed() != 0)
+      P->syncConflicts = 2000;
+    S = P;
+  } else
+    S = new Solver();
 #endif
+  if (Torc::Instance()->GetSeed() != 0)
+    S->random_seed = Torc::Instance()->GetSeed();
 
   return (Solver *)S;
 }
 
+double MaxSAT::initialSeed() { return Torc::Instance()->GetSeed(); }
+
 // Makes sure the underlying SAT solver has the given amount of variables
 // reserved.
 void MaxSAT::reserveSATVariables(Solver *S, unsigned maxVariable) {
@@ -78,48 +91,181 @@ void MaxSAT::reserveSATVariables(Solver *S, unsigned maxVariable) {
 
 // Creates a new variable in the SAT solver.
 void MaxSAT::newSATVariable(Solver *S) {
-	
-  static int count = 0;
 
 #ifdef SIMP
   ((NSPACE::SimpSolver *)S)->newVar();
 #else
-  count++;
-//  printf("Created new variable, count is : %d\n",count);
   S->newVar();
 #endif
 }
 
+// Adds (sign 1) or subtracts (sign -1) the counters of the SAT solver to 'c':
+// subtracting them before a SAT call and adding them after leaves the counters
+// of the call.
+static void countSATCall(Solver *S, SATCallStats &c, uint64_t sign) {
+  c.conflicts += sign * S->conflicts;
+  c.decisions += sign * S->decisions;
+  c.propagations += sign * S->propagations;
+  c.watchVisits += sign * S->stats[NSPACE::watchVisits];
+  c.blockerHits += sign * S->stats[NSPACE::blockerHits];
+  c.binPropagations += sign * S->stats[NSPACE::binPropagations];
+  c.longPropagations += sign * S->stats[NSPACE::longPropagations];
+  c.reduceDBs += sign * S->stats[NSPACE::nbReduceDB];
+  c.removedClauses += sign * S->stats[NSPACE::nbRemovedClauses];
+  c.garbageCollections += sign * S->stats[NSPACE::nbGarbageCollections];
+  c.garbageBytes += sign * S->stats[NSPACE::garbageBytes];
+  c.lubyRestarts += sign * S->stats[NSPACE::lubyRestarts];
+  c.lbdRestarts += sign * S->stats[NSPACE::lbdRestarts];
+  c.blockedRestarts += sign * S->stats[NSPACE::nbstopsrestarts];
+  for (int i = 0; i < lbdHistogramSize; i++)
+    c.lbd[i] += sign * S->stats[NSPACE::lbdHistogram + i];
+}
+
+// Sums the counters of a SAT call into 'total'.
+static void addSATCall(SATCallStats &total, const SATCallStats &c) {
+  total.result = c.result;
+  total.calls += c.calls;
+  total.conflicts += c.conflicts;
+  total.decisions += c.decisions;
+  total.propagations += c.propagations;
+  total.watchVisits += c.watchVisits;
+  total.blockerHits += c.blockerHits;
+  total.binPropagations += c.binPropagations;
+  total.longPropagations += c.longPropagations;
+  total.reduceDBs += c.reduceDBs;
+  total.removedClauses += c.removedClauses;
+  total.garbageCollections += c.garbageCollections;
+  total.garbageBytes += c.garbageBytes;
+  total.lubyRestarts += c.lubyRestarts;
+  total.lbdRestarts += c.lbdRestarts;
+  total.blockedRestarts += c.blockedRestarts;
+  for (int i = 0; i < lbdHistogramSize; i++)
+    total.lbd[i] += c.lbd[i];
+}
+
 // Solve the formula that is currently loaded in the SAT solver with a set of
 // assumptions and with the option to use preprocessing for 'simp'.
 lbool MaxSAT::searchSATSolver(Solver *S, vec<Lit> &assumptions, bool pre) {
 
-	if (Torc::Instance()->GetPolConservative() && model.size() > 0 ) {
+	bool warm = warmStart.size() > 0 && (model.size() == 0 || warmStartCost < modelCost);
+	vec<lbool> &phases = warm ? warmStart : model;
+	if (Torc::Instance()->GetPolConservative() && phases.size() > 0 ) {
 		//printf("c im in\n");
 		//S->_user_phase_saving = model;
 		S->_user_phase_saving.clear();
-		for (int i = 0; i < model.size(); i++){
-			S->_user_phase_saving.push(model[i]);		
+		for (int i = 0; i < phases.size(); i++){
+			S->_user_phase_saving.push(phases[i]);		
 		}
 		//S->_phase_saving_solution_based = _phase_saving_solution_based;
 		//S->_lns_params = _lns_params;
 	}
 	
-// Currently preprocessing is disabled by default.
-// Variable elimination cannot be done on relaxation variables nor on variables
-// that belong to soft clauses. To preprocessing to be used those variables
-// should be frozen.
+  {
+    std::lock_guard<std::mutex> guard(activeSolverLock);
+    if (interrupted)
+      throw InterruptedException();
+    activeSolver = S;
+  }
+
+  vec<Lit> extended;
+  if (fixedAssumptions.size() > 0) {
+    assumptions.copyTo(extended);
+    for (int i = 0; i < fixedAssumptions.size(); i++)
+      extended.push(fixedAssumptions[i]);
+  }
+  vec<Lit> &all = fixedAssumptions.size() > 0 ? extended : assumptions;
 
+  satLast = SATCallStats();
+  satLast.calls = 1;
+  countSATCall(S, satLast, -1);
 #ifdef SIMP
-  lbool res = ((NSPACE::SimpSolver *)S)->solveLimited(assumptions, pre);
+  // The first call on a solver preprocesses it, once (see 'freezeSATVariables').
+  bool simp = pre || S->solves == 0;
+  if (simp)
+    freezeSATVariables((NSPACE::SimpSolver *)S, all);
+  lbool res = ((NSPACE::SimpSolver *)S)->solveLimited(all, simp, simp);
 #else
-  lbool res = S->solveLimited(assumptions);
+  NSPACE::ParallelSolver *P = dynamic_cast<NSPACE::ParallelSolver *>(S);
+  lbool res = P != NULL ? P->solveParallel(all) : S->solveLimited(all);
 #endif
+  countSATCall(S, satLast, 1);
+  satLast.result = res;
+  addSATCall(satTotals, satLast);
+
+  {
+    std::lock_guard<std::mutex> guard(activeSolverLock);
+    activeSolver = NULL;
+  }
+  if (interrupted)
+    throw InterruptedException();
+
+  if (res == l_False && fixedAssumptions.size() > 0) {
+    // The conflict holds negated assumptions: keep those of the algorithm.
+    int j = 0;
+    for (int i = 0; i < S->conflict.size(); i++) {
+      Lit p = ~S->conflict[i];
+      if (var(p) >= fixedPolarity.size() ||
+          fixedPolarity[var(p)] != (sign(p) ? 2 : 1))
+        S->conflict[j++] = S->conflict[i];
+    }
+    S->conflict.shrink(S->conflict.size() - j);
+  }
+
+  if (solverCallback)
+    solverCallback(S);
 
   return res;
 }
 
+// Stops the search. Safe to call from a thread other than the one running
+// 'search': the SAT solver is only interrupted while it is inside
+// 'searchSATSolver', so it cannot be deleted under our feet.
+void MaxSAT::interrupt() {
+  std::lock_guard<std::mutex> guard(activeSolverLock);
+  interrupted = true;
+  if (activeSolver != NULL)
+    activeSolver->interrupt();
+}
+
 // Solve the formula without assumptions.
+#ifdef SIMP
+// Variable elimination may only remove variables that no later clause or
+// assumption uses. It therefore runs on the first SAT call of a solver only,
+// and freezes first the named variables of the formula (e.g. the variables the
+// timetabler decodes and fixes), the variables of the soft clauses and of the
+// objective with their relaxation and assumption variables, and the
+// assumptions of the call. This leaves the auxiliary variables of the
+// encodings to eliminate; the model is extended to them after each SAT call.
+void MaxSAT::freezeSATVariables(NSPACE::SimpSolver *S,
+                                const vec<Lit> &assumptions) {
+  const indexMap &names = maxsat_formula->getIndexToName();
+  for (indexMap::const_iterator it = names.begin(); it != names.end(); ++it)
+    if (it->first < S->nVars())
+      S->setFrozen(it->first, true);
+
+  vec<Lit> lits;
+  for (int i = 0; i < maxsat_formula->nSoft(); i++) {
+    Soft &soft = maxsat_formula->getSoftClause(i);
+    for (int j = 0; j < soft.clause.size(); j++)
+      lits.push(soft.clause[j]);
+    for (int j = 0; j < soft.relaxation_vars.size(); j++)
+      lits.push(soft.relaxation_vars[j]);
+    if (soft.assumption_var != lit_Undef)
+      lits.push(soft.assumption_var);
+  }
+  PBObjFunction *objective = maxsat_formula->getObjFunction();
+  if (objective != NULL)
+    for (int i = 0; i < objective->_lits.size(); i++)
+      lits.push(objective->_lits[i]);
+  for (int i = 0; i < assumptions.size(); i++)
+    lits.push(assumptions[i]);
+
+  for (int i = 0; i < lits.size(); i++)
+    if (var(lits[i]) < S->nVars())
+      S->setFrozen(var(lits[i]), true);
+}
+#endif
+
 lbool MaxSAT::searchSATSolver(Solver *S, bool pre) {
   vec<Lit> dummy; // Empty set of assumptions.
   return searchSATSolver(S, dummy, pre);
@@ -286,6 +432,9 @@ bool MaxSAT::isBMO(bool cache) {
 void MaxSAT::printBound(int64_t bound)
 {
   printf("o %" PRId64 "\n", bound);
+  modelCost = bound;
+  if (progressCallback)
+    progressCallback(bound);
 }
 
 // Prints information regarding the AMO encoding.
@@ -444,6 +593,27 @@ void MaxSAT::printStats() {
   printf("c  Nb UNSAT calls:         %12d\n", nbCores);
   printf("c  Average core size:      %12.2f\n", avgCoreSize);
   printf("c  Nb symmetry clauses:    %12d\n", nbSymmetryClauses);
+  if (satTotals.calls > 0) {
+    const SATCallStats &t = satTotals;
+    printf("c  SAT conflicts:          %12" PRIu64 "\n", t.conflicts);
+    printf("c  SAT decisions:          %12" PRIu64 "\n", t.decisions);
+    printf("c  SAT propagations:       %12" PRIu64 "\n", t.propagations);
+    printf("c  ... binary / long:      %12" PRIu64 " / %" PRIu64 "\n",
+           t.binPropagations, t.longPropagations);
+    printf("c  Watchers visited:       %12" PRIu64 "\n", t.watchVisits);
+    printf("c  ... blocker hits:       %12" PRIu64 "\n", t.blockerHits);
+    printf("c  Restarts luby/LBD:      %12" PRIu64 " / %" PRIu64
+           " (%" PRIu64 " blocked)\n",
+           t.lubyRestarts, t.lbdRestarts, t.blockedRestarts);
+    printf("c  ReduceDB / removed:     %12" PRIu64 " / %" PRIu64 "\n",
+           t.reduceDBs, t.removedClauses);
+    printf("c  Garbage collections:    %12" PRIu64 " (%" PRIu64 " bytes)\n",
+           t.garbageCollections, t.garbageBytes);
+    printf("c  Learnts by LBD:        ");
+    for (int i = 1; i < lbdHistogramSize; i++)
+      printf(" %" PRIu64, t.lbd[i]);
+    printf("\n");
+  }
   printf("c\n");
 }
 
@@ -610,7 +780,7 @@ void MaxSAT::BumpTargets(const vec<Lit>& objFunction, const vec<uint64_t>& coeff
 	if (Torc::Instance()->GetBumpRelWeights() == false) {
 		 for (int i = 0; i < objFunction.size(); i++) {
 			  auto v = var(objFunction[i]);			  
-			  solver->varBumpActivity(v, (double)Torc::Instance()->GetTargetVarsBumpVal() + (double)Torc::Instance()->GetRandBump());
+			  solver->varBumpActivity(v, (double)Torc::Instance()->GetTargetVarsBumpVal() + (double)Torc::Instance()->GetRandBump(randomState));
 		 }	
     }
 	else
@@ -638,7 +808,7 @@ void MaxSAT::BumpTargets(const vec<Lit>& objFunction, const vec<uint64_t>& coeff
 			  auto v = var(objFunction[i]);		
 			  const double currWeight = (double)coeffs[i];
 			  
-			  const double bumpVal = weightDomain == 0 ? maxBumpVal + (double)Torc::Instance()->GetRandBump() : (((currWeight - minWeight) / weightDomain) * maxBumpVal + (double)Torc::Instance()->GetRandBump());
+			  const double bumpVal = weightDomain == 0 ? maxBumpVal + (double)Torc::Instance()->GetRandBump(randomState) : (((currWeight - minWeight) / weightDomain) * maxBumpVal + (double)Torc::Instance()->GetRandBump(randomState));
 			  
 			  solver->varBumpActivity(v, bumpVal);
 			  //printf("Bumped %u of weight %f by %f (minWeight = %f ; maxWeight = %f)\n", v, currWeight, bumpVal, minWeight, maxWeight);
@@ -34,6 +34,7 @@
 #include "simp/SimpSolver.h"
 #else
 #include "core/Solver.h"
+#include "parallel/ParallelSolver.h"
 #endif
 
 #include "MaxSATFormula.h"
@@ -46,6 +47,8 @@
 #include <cinttypes>
 
 #include <vector>
+#include <functional>
+#include <mutex>
 #include "MaxSATFormulaExtended.h"
 
 using NSPACE::vec;
@@ -58,6 +61,35 @@ using NSPACE::cpuTime;
 
 namespace openwbo {
 
+// Thrown out of 'search' when the search was stopped through 'interrupt'.
+// The best model found so far (if any) is still available in 'model'.
+class InterruptedException {};
+
+// Counters of the SAT solver over SAT calls, see 'lastSATCall'. They cost a
+// few increments in the hot loops of the solver (see 'CoreStats' in
+// core/Solver.h), so they are always on. A parallel SAT call only counts the
+// solver of the first thread.
+struct SATCallStats {
+  lbool result = l_Undef; // Of the last call only.
+  uint64_t calls = 0;
+  uint64_t conflicts = 0;
+  uint64_t decisions = 0;
+  uint64_t propagations = 0;
+  uint64_t watchVisits = 0;  // Watchers of long clauses visited,
+  uint64_t blockerHits = 0;  // ... of which skipped thanks to their blocker.
+  uint64_t binPropagations = 0;
+  uint64_t longPropagations = 0;
+  uint64_t reduceDBs = 0;
+  uint64_t removedClauses = 0;
+  uint64_t garbageCollections = 0;
+  uint64_t garbageBytes = 0; // Bytes reclaimed by the collections.
+  uint64_t lubyRestarts = 0;
+  uint64_t lbdRestarts = 0;     // Dynamic restarts (lbdQueue),
+  uint64_t blockedRestarts = 0; // and those blocked by the trailQueue.
+  // Learnt clauses by LBD, the last bucket for LBD >= lbdHistogramSize - 1.
+  uint64_t lbd[lbdHistogramSize] = {};
+};
+
 class MaxSAT {
 
 public:
@@ -78,6 +110,14 @@ public:
     sumSizeCores = 0;
 
     print_model = false;
+
+    interrupted = false;
+    activeSolver = NULL;
+    resumePhase = 0;
+    warmStartCost = UINT64_MAX;
+    modelCost = UINT64_MAX;
+    randomState = initialSeed();
+    satThreads = 1;
   }
 
   MaxSAT() {
@@ -97,6 +137,14 @@ public:
     sumSizeCores = 0;
 
     print_model = false;
+
+    interrupted = false;
+    activeSolver = NULL;
+    resumePhase = 0;
+    warmStartCost = UINT64_MAX;
+    modelCost = UINT64_MAX;
+    randomState = initialSeed();
+    satThreads = 1;
   }
 
   virtual ~MaxSAT() {
@@ -161,6 +209,65 @@ public:
   void setPrintModel(bool model) { print_model = model; }
   bool getPrintModel() { return print_model; }
 
+  // Called with every new upper bound, after 'model' has been updated.
+  void setProgressCallback(std::function<void(uint64_t)> callback) {
+    progressCallback = callback;
+  }
+
+  // Stops the search from another thread. The SAT call in progress returns
+  // and 'search' throws an InterruptedException.
+  void interrupt();
+  bool isInterrupted() { return interrupted; }
+
+  // Literals assumed in every SAT call on top of the algorithm's own
+  // assumptions, e.g. to fix part of a solution. They are removed from the
+  // cores handed to the algorithm, so the problem is solved as if they were
+  // hard units; if they are inconsistent the formula is reported UNSAT.
+  void setFixedAssumptions(const vec<Lit> &lits) {
+    lits.copyTo(fixedAssumptions);
+    fixedPolarity.clear();
+    for (int i = 0; i < lits.size(); i++) {
+      if (var(lits[i]) >= fixedPolarity.size())
+        fixedPolarity.growTo(var(lits[i]) + 1, 0);
+      fixedPolarity[var(lits[i])] = sign(lits[i]) ? 2 : 1;
+    }
+  }
+
+  // Checkpoints (see api/Checkpoint.h)
+  //
+  // Called after every SAT call with the SAT solver, e.g. to export the
+  // clauses it learnt.
+  void setSolverCallback(std::function<void(Solver *)> callback) {
+    solverCallback = callback;
+  }
+  // Polarity of the SAT calls (used by the conservative polarity heuristic)
+  // until the search finds a model cheaper than 'cost', e.g. the best model
+  // of a previous run or of another solver.
+  void setWarmStart(const vec<lbool> &start, uint64_t cost = UINT64_MAX) {
+    start.copyTo(warmStart);
+    warmStartCost = cost;
+  }
+  // Phase reached by the search, e.g. the stratification level, and the
+  // phase to start from when resuming. 0 when the algorithm has none.
+  virtual uint64_t getPhase() { return 0; }
+  void setResumePhase(uint64_t phase) { resumePhase = phase; }
+  // Lower bound on the cost proven so far, 0 when unknown.
+  virtual uint64_t getLowerBound() { return 0; }
+  // True if the clauses learnt by the SAT solver over the variables of the
+  // formula follow from its hard clauses, i.e. the algorithm never adds
+  // clauses that depend on the bounds.
+  virtual bool learntsAreImplied() { return false; }
+  // Conflicts of all the SAT calls so far, a measure of progress that does
+  // not depend on the machine or the load (see api/Portfolio.h).
+  uint64_t satConflicts() { return satTotals.conflicts; }
+  // Counters of the last SAT call, e.g. to read from the solver callback, and
+  // their sums over all the SAT calls so far.
+  const SATCallStats &lastSATCall() { return satLast; }
+  const SATCallStats &satCallTotals() { return satTotals; }
+  // Threads of the hard SAT calls (see parallel/ParallelSolver.h), for the
+  // SAT solvers built afterwards.
+  void setSATThreads(int threads) { satThreads = threads; }
+
 // Properties of the MaxSAT formula
 //
 vec<lbool> model;
@@ -172,6 +279,10 @@ protected:
   // Solves the formula that is currently loaded in the SAT solver.
   lbool searchSATSolver(Solver *S, vec<Lit> &assumptions, bool pre = false);
   lbool searchSATSolver(Solver *S, bool pre = false);
+#ifdef SIMP
+  // Freezes the variables that variable elimination must keep.
+  void freezeSATVariables(NSPACE::SimpSolver *S, const vec<Lit> &assumptions);
+#endif
 
   void newSATVariable(Solver *S); // Creates a new variable in the SAT solver.
 
@@ -216,6 +327,26 @@ protected:
   void printModel(); // Print the best satisfying model.
   void printStats(); // Print search statistics.
 
+  // Interruption and progress reporting
+  //
+  std::function<void(uint64_t)> progressCallback;
+  volatile bool interrupted;
+  Solver *activeSolver; // SAT solver running in 'searchSATSolver', if any.
+  std::mutex activeSolverLock;
+  vec<Lit> fixedAssumptions; // See 'setFixedAssumptions'.
+  vec<char> fixedPolarity;   // Per variable: 0 free, 1 assumed true, 2 false.
+  std::function<void(Solver *)> solverCallback;
+  vec<lbool> warmStart; // See 'setWarmStart'.
+  uint64_t warmStartCost;
+  uint64_t modelCost; // Cost of 'model' given to 'printBound'.
+  uint64_t resumePhase; // See 'setResumePhase'.
+  // Random bumps of this algorithm and seed of its SAT solvers, see
+  // 'Torc::SetSeed'.
+  static double initialSeed();
+  double randomState;
+  SATCallStats satLast, satTotals; // See 'lastSATCall'.
+  int satThreads; // See 'setSATThreads'.
+
   // Greater than comparator.
   bool static greaterThan(uint64_t i, uint64_t j) { return (i > j); }
   
@@ -190,6 +190,17 @@ int MaxSATFormula::newVarName(char *varName) {
   return id;
 }
 
+int MaxSATFormula::addVarName(const std::string &varName) {
+  std::pair<nameMap::iterator, bool> added =
+      _nameToIndex.insert(std::make_pair(varName, nVars()));
+  if (added.second) {
+    // Identifiers only grow: append to the end of the index.
+    _indexToName.insert(_indexToName.end(), std::make_pair(nVars(), varName));
+    newVar();
+  }
+  return added.first->second;
+}
+
 int MaxSATFormula::varID(char *varName) {
   std::string s(varName);
 
@@ -182,6 +182,8 @@ public:
 
   int newVarName(char *varName);
   int varID(char *varName);
+  // Same as newVarName, with one lookup of the name.
+  int addVarName(const std::string &varName);
 
   void addObjFunction(PBObjFunction *of) {
     objective_function = new PBObjFunction(of->_lits, of->_coeffs, of->_const);
@@ -4,13 +4,13 @@
 #include "MaxSAT.h"
 #include "Torc.h"
 
-// Global static pointer used to ensure a single instance of the class.
-Torc* Torc::m_pInstance = NULL;
+// Only allow one instance of class to be generated. The parameters are set
+// once at start-up and only read afterwards, so the instance can be shared
+// by solvers running in different threads.
 Torc* Torc::Instance()
 {
-   if (!m_pInstance)   // Only allow one instance of class to be generated.
-      m_pInstance = new Torc;
-   return m_pInstance;
+   static Torc instance; // Initialised once, even with concurrent callers.
+   return &instance;
 }
 
 int Torc::GetRandBump() const
@@ -18,3 +18,16 @@ int Torc::GetRandBump() const
 	return varTargetsBumpMaxRandVal == 0 ? 0 : rand() % varTargetsBumpMaxRandVal;
 }
 
+
+int Torc::GetRandBump(double &state) const
+{
+	if (state == 0)
+		return GetRandBump();
+	if (varTargetsBumpMaxRandVal == 0)
+		return 0;
+	// Same generator as the random decisions of Glucose
+	state *= 1389796;
+	int q = (int)(state / 2147483647);
+	state -= (double)q * 2147483647;
+	return (int)(state / 2147483647 * varTargetsBumpMaxRandVal);
+}
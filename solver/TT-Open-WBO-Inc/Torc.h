@@ -11,6 +11,11 @@ public:
    void SetTargetVarsBumpVal(int targetVarsBumpVal) { varTargetsBumpVal = targetVarsBumpVal; }   
    void SetBumpRelWeights(bool isBumpRelWeights) { bumpRelWeights = isBumpRelWeights; }   
    void SetTargetBumpMaxRandVal(int targetVarsBumpRandVal) { varTargetsBumpMaxRandVal = targetVarsBumpRandVal; }   
+   // 0 draws the random bumps from the process-wide rand(), whose sequence
+   // depends on the interleaving of the threads. Otherwise every MaxSAT
+   // algorithm (and the SAT solvers it builds) draws from its own generator
+   // started from this seed, so that parallel runs are reproducible.
+   void SetSeed(double s) { seed = s; }
    
    bool GetPolConservative() const { return polIsConservative; }
    bool GetConservativeAllVars() const { return conservativeUseAllVars; } 
@@ -18,13 +23,13 @@ public:
    int GetTargetVarsBumpVal() const { return varTargetsBumpVal; }   
    bool GetBumpRelWeights() const { return bumpRelWeights; }
    int GetTargetBumpMaxRandVal() const { return varTargetsBumpMaxRandVal; }   
+   double GetSeed() const { return seed; }
    
    int GetRandBump() const;
-
-   vec<bool>& TargetIsVarTarget() { return isVarTarget; }
+   // Draws from 'state', a generator started from 'GetSeed', if not 0.
+   int GetRandBump(double &state) const;
 private:
-   Torc() : polIsConservative(true), conservativeUseAllVars(true), polIsOptimistic(true), varTargetsBumpVal(113), bumpRelWeights(false), varTargetsBumpMaxRandVal(0)  {};  // Private so that it can  not be called
-   static Torc* m_pInstance;
+   Torc() : polIsConservative(true), conservativeUseAllVars(true), polIsOptimistic(true), varTargetsBumpVal(113), bumpRelWeights(false), varTargetsBumpMaxRandVal(0), seed(0)  {};  // Private so that it can  not be called
 
    bool polIsConservative;
    bool conservativeUseAllVars;
@@ -32,8 +37,7 @@ private:
    int varTargetsBumpVal;  
    bool bumpRelWeights;    
    int varTargetsBumpMaxRandVal;  
-   
-   vec<bool> isVarTarget;
+   double seed;
 };
 
 
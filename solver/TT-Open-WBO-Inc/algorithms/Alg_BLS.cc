@@ -106,7 +106,8 @@ lbool BLS::solve() {
     solver->setConfBudget(conflict_limit);
 
 #ifdef SIMP
-  return ((SimpSolver*)solver)->solveLimited(assumptions);
+  // Through MaxSAT, which freezes what variable elimination must keep.
+  return searchSATSolver(solver, assumptions);
 #else
   return solver->solveLimited(assumptions);
 #endif
@@ -241,7 +242,7 @@ bool BLS::findNextMCS() {
   	uint64_t newCost = computeCostModel(solver->model);
   	if (newCost < _smallestMCS){
   		saveModel(solver->model);	
-  		printf("o %" PRId64 "\n", newCost);
+  		printBound(newCost);
   		_smallestMCS = newCost;
   	}
   }
@@ -275,7 +276,7 @@ bool BLS::findNextMCS() {
       if (costModel < _smallestMCS) {
 	       //saveSmallestModel(solver->model);
       	   saveModel(solver->model);
-	       printf("o %" PRId64 "\n", costModel);
+	       printBound(costModel);
 	       _smallestMCS = costModel;
       }
     }
@@ -299,8 +300,8 @@ bool BLS::findNextMCS() {
     else if (res == l_True) {
       costModel -= maxsat_formula->getSoftClause(satClauses.last()).weight;
       if (undefClauses.size() == 0 && costModel < _smallestMCS){
-        printf("o %" PRId64 "\n", costModel);
         saveModel(solver->model);
+        printBound(costModel);
         _smallestMCS = costModel;
       }
     }
@@ -204,13 +204,13 @@ StatusCode LinearSUClustering::bmoSearch() throw() {
   
     if (Torc::Instance()->GetPolOptimistic())
 	{
-		 if (Torc::Instance()->TargetIsVarTarget().size() == 0) {
-			  Torc::Instance()->TargetIsVarTarget().growTo(solver->nVars(), false);
+		 if (solver->_target_vars.size() == 0) {
+			  solver->_target_vars.growTo(solver->nVars());
 			  
 			  for (int i = 0; i < objFunction.size(); i++) {
 				  auto v = var(objFunction[i]);
 				  assert(sign(objFunction[i]) == 0);
-				  Torc::Instance()->TargetIsVarTarget()[v] = true;				  				  
+				  solver->_target_vars.insert(v);				  				  
 			  }			  
 		  }		
 	}
@@ -230,7 +230,7 @@ StatusCode LinearSUMod::bmoSearch() {
           saveModel(solver->model);
           solver->model.copyTo(best_model);
           best_cost = originalCost;
-          printf("o %" PRId64 "\n", originalCost);
+          printBound(originalCost);
         }
         ubCost = newCost + lbCost;
       } else {
@@ -365,10 +365,10 @@ StatusCode LinearSUMod::normalSearch() {
         if (maxsat_formula->getFormat() == _FORMAT_PB_) {
           // optimization problem
           if (maxsat_formula->getObjFunction() != NULL) {
-            printf("o %" PRId64 "\n", originalCost);
+            printBound(originalCost);
           }
         } else {
-          printf("o %" PRId64 "\n", originalCost);
+          printBound(originalCost);
         }
       }
 
@@ -49,7 +49,7 @@ uint64_t OBV::MrsBeaver(Solver * solver, int iterations, int conflicts, uint64_t
 
   uint64_t current_ub = computeCostModel(solver->model);
   saveModel(solver->model);
-  printf("o %" PRId64 "\n", current_ub);
+  printBound(current_ub);
   
   vec<lbool> original_model;
   solver->model.copyTo(original_model);
@@ -123,7 +123,7 @@ uint64_t OBV::obv_bs(Solver * solver, std::vector<Lit>& outputs, uint64_t ub, in
         uint64_t newCost = computeCostModel(solver->model);
         if (newCost < last_ub){
           saveModel(solver->model);
-          printf("o %" PRId64 "\n", newCost);
+          printBound(newCost);
           last_ub = newCost;
         }
         current_model.clear();
@@ -195,7 +195,7 @@ uint64_t OBV::ums_obv_bs(Solver * solver, std::vector<Lit>& outputs, uint64_t ub
         uint64_t newCost = computeCostModel(solver->model);
         if (newCost < last_ub){
           saveModel(solver->model);
-          printf("o %" PRId64 "\n", newCost);
+          printBound(newCost);
           last_ub = newCost;
         }
         current_model.clear();
@@ -238,13 +238,13 @@ StatusCode OBV::normalSearch() {
   
   if (Torc::Instance()->GetPolOptimistic())
 	{
-		 if (Torc::Instance()->TargetIsVarTarget().size() == 0) {
-			  Torc::Instance()->TargetIsVarTarget().growTo(solver->nVars(), false);
+		 if (solver->_target_vars.size() == 0) {
+			  solver->_target_vars.growTo(solver->nVars());
 			  
 			  for (int i = 0; i < objFunction.size(); i++) {
 				  auto v = var(objFunction[i]);
 				  assert(sign(objFunction[i]) == 0);
-				  Torc::Instance()->TargetIsVarTarget()[v] = true;				  				  
+				  solver->_target_vars.insert(v);				  				  
 			  }			  
 		  }		
 	}
@@ -283,7 +283,7 @@ StatusCode OBV::normalSearch() {
       } else {
         mrsb = false;
       }
-      printf("o %" PRId64 "\n", newCost + off_set); 
+      printBound(newCost + off_set); 
       
 	  if (newCost == 0) {
         // If there is a model with value 0 then it is an optimal model
@@ -335,8 +335,11 @@ StatusCode OLL::weighted() {
       }
 
       if (nbSatisfiable == 1) {
-        min_weight =
-            findNextWeightDiversity(min_weight, cardinality_assumptions);
+        if (resumePhase > 0 && resumePhase < min_weight)
+          min_weight = resumePhase;
+        else
+          min_weight =
+              findNextWeightDiversity(min_weight, cardinality_assumptions);
         // printf("current weight %d\n",min_weight);
 
         for (int i = 0; i < maxsat_formula->nSoft(); i++)
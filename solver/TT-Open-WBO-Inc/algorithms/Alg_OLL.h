@@ -65,6 +65,13 @@ public:
         }
     }
 
+  // Stratification level: the minimum weight of the soft clauses in the
+  // cores. Cores only add totalizers over fresh variables, so the learnt
+  // clauses over the variables of the formula follow from its hard clauses.
+  uint64_t getPhase() { return min_weight; }
+  uint64_t getLowerBound() { return lbCost + off_set; }
+  bool learntsAreImplied() { return true; }
+
   // Print solver configuration.
   void printConfiguration() {
 
@@ -214,10 +214,10 @@ StatusCode OLLMod::unweighted() {
         if (maxsat_formula->getFormat() == _FORMAT_PB_) {
           // optimization problem
           if (maxsat_formula->getObjFunction() != NULL) {
-            printf("o %" PRId64 "\n", originalCost);
+            printBound(originalCost);
           }
         } else {
-          printf("o %" PRId64 "\n", originalCost);
+          printBound(originalCost);
         }
       }
 
@@ -425,18 +425,21 @@ StatusCode OLLMod::weighted() {
           if (maxsat_formula->getFormat() == _FORMAT_PB_) {
             // optimization problem
             if (maxsat_formula->getObjFunction() != NULL) {
-              printf("o %" PRId64 "\n", originalCost);
+              printBound(originalCost);
             }
           } else {
-            printf("o %" PRId64 "\n", originalCost);
+            printBound(originalCost);
           }
         }
         ubCost = newCost;
       }
 
       if (nbSatisfiable == 1) {
-        min_weight =
-            findNextWeightDiversity(min_weight, cardinality_assumptions);
+        if (resumePhase > 0 && resumePhase < min_weight)
+          min_weight = resumePhase;
+        else
+          min_weight =
+              findNextWeightDiversity(min_weight, cardinality_assumptions);
         // printf("current weight %d\n",min_weight);
 
         for (int i = 0; i < maxsat_formula->nSoft(); i++)
@@ -75,6 +75,12 @@ public:
         }
     }
 
+  // Stratification level: the minimum weight of the soft clauses in the
+  // cores. Cores only add totalizers over fresh variables, so the learnt
+  // clauses over the variables of the formula follow from its hard clauses.
+  uint64_t getPhase() { return min_weight; }
+  bool learntsAreImplied() { return true; }
+
   void initializeCluster();
 
   // Print solver configuration.
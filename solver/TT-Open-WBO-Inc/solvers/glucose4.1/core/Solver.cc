@@ -120,6 +120,15 @@ static BoolOption opt_fixed_randomize_phase_on_restarts(_cat, "fix-phas-rest", "
 static BoolOption opt_adapt(_cat, "adapt", "Adapt dynamically stategies after 100000 conflicts", true);
 
 static BoolOption opt_forceunsat(_cat,"forceunsat","Force the phase for UNSAT",true);
+
+// Learnt clause vivification is part of the preprocessing build (VERSION=simp), see MaxSAT.cc.
+#ifdef SIMP
+static const int defaultVivify = 20000;
+#else
+static const int defaultVivify = 0;
+#endif
+static IntOption opt_vivify(_cat, "vivify", "Conflicts between two vivifications of the learnt clauses (0=never)", defaultVivify, IntRange(0, INT32_MAX));
+static IntOption opt_bulk_assumptions(_cat, "bulk-assumptions", "Assumptions from which they are all propagated at one decision level (0=never)", 1000, IntRange(0, INT32_MAX));
 //=================================================================================================
 // Constructor/Destructor:
 
@@ -152,6 +161,8 @@ verbosity(0)
 , rnd_init_act(opt_rnd_init_act)
 , randomizeFirstDescent(false)
 , garbage_frac(opt_garbage_frac)
+, bulkAssumptions(opt_bulk_assumptions)
+, vivifyInterval(opt_vivify)
 , certifiedOutput(NULL)
 , certifiedUNSAT(false) // Not in the first parallel version
 , vbyte(false)
@@ -170,6 +181,10 @@ verbosity(0)
 , newDescent(0)
 , randomDescentAssignments(0)
 , forceUnsatOnNewDescent(opt_forceunsat)
+, polOptimistic(Torc::Instance()->GetPolOptimistic())
+, polConservative(Torc::Instance()->GetPolConservative())
+, assumptionLevel(false)
+, nextVivify(opt_vivify), vivifyProps(0)
 
 , ok(true)
 , cla_inc(1)
@@ -236,6 +251,8 @@ Solver::Solver(const Solver &s) :
 , rnd_init_act(s.rnd_init_act)
 , randomizeFirstDescent(s.randomizeFirstDescent)
 , garbage_frac(s.garbage_frac)
+, bulkAssumptions(s.bulkAssumptions)
+, vivifyInterval(s.vivifyInterval)
 , certifiedOutput(NULL)
 , certifiedUNSAT(false) // Not in the first parallel version
 , panicModeLastRemoved(s.panicModeLastRemoved), panicModeLastRemovedShared(s.panicModeLastRemovedShared)
@@ -256,6 +273,10 @@ Solver::Solver(const Solver &s) :
 , newDescent(s.newDescent)
 , randomDescentAssignments(s.randomDescentAssignments)
 , forceUnsatOnNewDescent(s.forceUnsatOnNewDescent)
+, polOptimistic(s.polOptimistic)
+, polConservative(s.polConservative)
+, assumptionLevel(false)
+, nextVivify(s.nextVivify), vivifyProps(0)
 , ok(true)
 , cla_inc(s.cla_inc)
 , var_inc(s.var_inc)
@@ -456,7 +477,7 @@ bool Solver::addClause_(vec <Lit> &ps) {
         return ok = false;
     } else if(ps.size() == 1) {
         uncheckedEnqueue(ps[0]);
-        return  (propagate() == CRef_Undef);
+        return ok = (propagate() == CRef_Undef);
     } else {
         CRef cr = ca.alloc(ps, false);
         clauses.push(cr);
@@ -701,37 +722,16 @@ Lit Solver::pickBranchLit() {
             next = order_heap.removeMin();
         }
 
-    if(1 == 2 && randomize_on_restarts && !fixed_randomize_on_restarts && newDescent && (decisionLevel() % 2 == 0)) {
-        return mkLit(next, (randomDescentAssignments >> (decisionLevel() % 32)) & 1);
-    }
+    if(next == var_Undef) return lit_Undef;
 
-    if(1 == 2 && fixed_randomize_on_restarts && decisionLevel() < 7) {
-        return mkLit(next, (randomDescentAssignments >> (decisionLevel() % 32)) & 1);
-    }
+    if (polOptimistic && _target_vars.has(next))
+        return mkLit(next, 1);
 
-    if(next == var_Undef) return lit_Undef;
-    
-    /*static unsigned opts = 0;
-    static unsigned convs = 0;
-    static const unsigned poc = 10000;*/
-   
-    if (Torc::Instance()->GetPolOptimistic() && next < Torc::Instance()->TargetIsVarTarget().size())
-    {
-		bool found = Torc::Instance()->TargetIsVarTarget()[next]; 
-		if (found) {
-			/*++opts;
-			if (opts % poc == 0) printf("c Optimistic #%u\n", opts);*/
-			return mkLit(next, 1);			
-		}
-	}
-	
-	if (Torc::Instance()->GetPolConservative() && next < _user_phase_saving.size())
+    if (polConservative && next < _user_phase_saving.size())
     {
-		assert(_user_phase_saving[next] == l_True || _user_phase_saving[next] == l_False);
-		/*++convs;
-		if (convs % poc == 0) printf("c Conservatives #%u\n", convs);*/
-		return mkLit(next, _user_phase_saving[next] != l_True);
-	}
+        assert(_user_phase_saving[next] == l_True || _user_phase_saving[next] == l_False);
+        return mkLit(next, _user_phase_saving[next] != l_True);
+    }
 
     if(forceUnsatOnNewDescent && newDescent) {
         if(forceUNSAT[next] != 0)
@@ -1002,12 +1002,36 @@ void Solver::analyzeFinal(Lit p, vec <Lit> &out_conflict) {
     out_conflict.clear();
     out_conflict.push(p);
 
-    if(decisionLevel() == 0)
+    if(decisionLevel() == 0 || level(var(p)) == 0)
         return;
 
     seen[var(p)] = 1;
+    analyzeFinalMarked(1, out_conflict);
+}
+
+
+// Same, for a conflict clause found while only the assumptions are assigned (see 'assumptionLevel').
+void Solver::analyzeFinal(CRef confl, vec <Lit> &out_conflict) {
+    out_conflict.clear();
+
+    Clause &c = ca[confl];
+    int marked = 0;
+    for(int i = 0; i < c.size(); i++) {
+        Var x = var(c[i]);
+        if(!seen[x] && level(x) > 0) {
+            seen[x] = 1;
+            marked++;
+        }
+    }
+    analyzeFinalMarked(marked, out_conflict);
+}
 
-    for(int i = trail.size() - 1; i >= trail_lim[0]; i--) {
+
+// Walks the trail down while 'marked' variables are still marked in 'seen', and stops there
+// instead of at the first assumption: with thousands of assumptions the conflict usually
+// involves the last few only.
+void Solver::analyzeFinalMarked(int marked, vec <Lit> &out_conflict) {
+    for(int i = trail.size() - 1; marked > 0; i--) {
         Var x = var(trail[i]);
         if(seen[x]) {
             if(reason(x) == CRef_Undef) {
@@ -1018,16 +1042,19 @@ void Solver::analyzeFinal(Lit p, vec <Lit> &out_conflict) {
                 //                for (int j = 1; j < c.size(); j++) Minisat (glucose 2.0) loop
                 // Bug in case of assumptions due to special data structures for Binary.
                 // Many thanks to Sam Bayless (sbayless@cs.ubc.ca) for discover this bug.
-                for(int j = ((c.size() == 2) ? 0 : 1); j < c.size(); j++)
-                    if(level(var(c[j])) > 0)
-                        seen[var(c[j])] = 1;
+                for(int j = ((c.size() == 2) ? 0 : 1); j < c.size(); j++) {
+                    Var y = var(c[j]);
+                    if(!seen[y] && level(y) > 0) {
+                        seen[y] = 1;
+                        marked++;
+                    }
+                }
             }
 
             seen[x] = 0;
+            marked--;
         }
     }
-
-    seen[var(p)] = 0;
 }
 
 
@@ -1060,6 +1087,7 @@ CRef Solver::propagate() {
     CRef confl = CRef_Undef;
     vec<Lit> tempL;
     int num_props = 0;
+    uint64_t num_visits = 0, num_blocked = 0, num_bin = 0, num_long = 0;
     watches.cleanAll();
     watchesBin.cleanAll();
     unaryWatches.cleanAll();
@@ -1077,11 +1105,13 @@ CRef Solver::propagate() {
             Lit imp = wbin[k].blocker;
 
             if(value(imp) == l_False) {
-                return wbin[k].cref;
+                confl = wbin[k].cref;
+                goto Done;
             }
 
             if(value(imp) == l_Undef) {
                 uncheckedEnqueue(imp, wbin[k].cref);
+                num_bin++;
             }
         }
 
@@ -1090,6 +1120,7 @@ CRef Solver::propagate() {
             // Try to avoid inspecting the clause:
             Lit blocker = i->blocker;
             if(value(blocker) == l_True) {
+                num_blocked++;
                 *j++ = *i++;
                 continue;
             }
@@ -1158,16 +1189,17 @@ CRef Solver::propagate() {
             if(value(first) == l_False) {
                 confl = cr;
                 qhead = trail.size();
+                num_visits -= end - i;
                 // Copy the remaining watches:
                 while(i < end)
                     *j++ = *i++;
             } else {
                 uncheckedEnqueue(first, cr);
-
-
+                num_long++;
             }
             NextClause:;
         }
+        num_visits += ws.size();
         ws.shrink(i - j);
 
         // unaryWatches "propagation"
@@ -1181,6 +1213,12 @@ CRef Solver::propagate() {
 
     propagations += num_props;
     simpDB_props -= num_props;
+    // A conflict on a binary clause jumps here: 'propagations' never counted it.
+Done:
+    stats[watchVisits] += num_visits;
+    stats[blockerHits] += num_blocked;
+    stats[binPropagations] += num_bin;
+    stats[longPropagations] += num_long;
     if(confl == CRef_Undef){
         for (int i = 0; i <tempL.size() ; ++i) {
             errorP.push(tempL[i]);
@@ -1325,6 +1363,102 @@ void Solver::reduceDB() {
 }
 
 
+/*_________________________________________________________________________________________________
+|
+|  vivifyLearnts : [void]  ->  [bool]
+|  
+|  Description:
+|    At level 0, assigns the negation of the literals of a learnt clause one after the other, with
+|    the clause detached, until they imply the rest of it: a literal found false is dropped, and a
+|    literal found true or a conflict cuts the clause there. Permanent learnt clauses and learnt
+|    clauses of LBD at most 'lbLBDMinimizingClause' are visited, the newest first, for a tenth of
+|    the propagations made since the last call. Returns FALSE if the formula is unsatisfiable.
+|________________________________________________________________________________________________@*/
+bool Solver::vivifyLearnts() {
+    assert(decisionLevel() == 0);
+    nextVivify = conflicts + vivifyInterval;
+    uint64_t budget = propagations + (propagations - vivifyProps) / 10;
+
+    // The trial assignments must not overwrite the saved phases:
+    int saved_phase_saving = phase_saving;
+    phase_saving = 0;
+
+    vec <Lit> lits;
+    for(int k = 0; k < 2 && ok; k++) {
+        vec <CRef> &cs = k == 0 ? permanentLearnts : learnts;
+        bool removed = false;
+        for(int i = cs.size() - 1; i >= 0 && ok && propagations < budget; i--) {
+            CRef cr = cs[i];
+            Clause &c = ca[cr];
+            if(c.mark() == 1) {
+                // Second entry of a clause replaced above ('analyze' may push a clause twice on
+                // 'permanentLearnts'):
+                cs[i] = CRef_Undef;
+                removed = true;
+                continue;
+            }
+            if(c.size() <= 2 || (c.learnt() && c.lbd() > lbLBDMinimizingClause) || satisfied(c))
+                continue;
+
+            detachClause(cr, true);
+            lits.clear();
+            newDecisionLevel();
+            for(int j = 0; j < c.size(); j++) {
+                Lit p = c[j];
+                if(value(p) == l_False)
+                    continue;
+                lits.push(p);
+                if(value(p) == l_True)
+                    break;
+                uncheckedEnqueue(~p);
+                if(propagate() != CRef_Undef)
+                    break;
+            }
+            cancelUntil(0);
+
+            if(lits.size() == c.size()) {
+                attachClause(cr);
+                continue;
+            }
+            stats[nbVivified]++;
+            bool learnt = c.learnt();
+            unsigned int lbd = c.lbd();
+            float act = learnt ? c.activity() : 0;
+            c.mark(1);
+            ca.free(cr);
+
+            if(lits.size() <= 1) {
+                cs[i] = CRef_Undef;
+                removed = true;
+                if(lits.size() == 0 || (uncheckedEnqueue(lits[0]), propagate() != CRef_Undef))
+                    ok = false;
+                continue;
+            }
+            CRef nr = ca.alloc(lits, learnt);
+            if(learnt) {
+                ca[nr].setLBD(lbd < (unsigned int) lits.size() ? lbd : lits.size());
+                ca[nr].activity() = act;
+                ca[nr].setOneWatched(false);
+            }
+            attachClause(nr);
+            cs[i] = nr;
+        }
+        if(removed) {
+            int i, j;
+            for(i = j = 0; i < cs.size(); i++)
+                if(cs[i] != CRef_Undef)
+                    cs[j++] = cs[i];
+            cs.shrink(i - j);
+        }
+    }
+
+    phase_saving = saved_phase_saving;
+    vivifyProps = propagations;
+    checkGarbage();
+    return ok;
+}
+
+
 void Solver::removeSatisfied(vec <CRef> &cs) {
 
     int i, j;
@@ -1549,6 +1683,11 @@ lbool Solver::search(int nof_conflicts) {
                 return l_False;
 
             }
+            if(assumptionLevel && decisionLevel() == 1) {
+                // The assumptions contradict each other (level 1 holds them all):
+                analyzeFinal(confl, conflict);
+                return l_False;
+            }
             if(adaptStrategies && conflicts == 100000) {
                 cancelUntil(0);
                 adaptSolver();
@@ -1575,6 +1714,7 @@ lbool Solver::search(int nof_conflicts) {
 
             lbdQueue.push(nblevels);
             sumLBD += nblevels;
+            stats[lbdHistogram + std::min<int>(nblevels, lbdHistogramSize - 1)]++;
 
             cancelUntil(backtrack_level);
 
@@ -1632,11 +1772,16 @@ lbool Solver::search(int nof_conflicts) {
                (!luby_restart && (lbdQueue.isvalid() && ((lbdQueue.getavg() * K) > (sumLBD / conflictsRestarts))))) {
                 lbdQueue.fastclear();
                 progress_estimate = progressEstimate();
+                stats[luby_restart ? lubyRestarts : lbdRestarts]++;
                 int bt = 0;
 #ifdef INCREMENTAL
                 if(incremental) // DO NOT BACKTRACK UNTIL 0.. USELESS
                     bt = (decisionLevel()<assumptions.size()) ? decisionLevel() : assumptions.size();
 #endif
+                // Keep the propagated assumptions, except every 16 restarts to reach level 0 for
+                // simplify() and the clauses imported from other workers:
+                if(assumptionLevel && starts % 16 != 0)
+                    bt = 1;
                 newDescent = true;
 
                 if(randomize_on_restarts || fixed_randomize_on_restarts) {
@@ -1652,6 +1797,9 @@ lbool Solver::search(int nof_conflicts) {
             if(decisionLevel() == 0 && !simplify()) {
                 return l_False;
             }
+            if(decisionLevel() == 0 && vivifyInterval > 0 && conflicts >= nextVivify && !certifiedUNSAT && !vivifyLearnts()) {
+                return l_False;
+            }
             // Perform clause database reduction !
             if((chanseokStrategy && !glureduce && learnts.size() > firstReduceDB) ||
                (glureduce && conflicts >= ((unsigned int) curRestart * nbclausesbeforereduce))) {
@@ -1666,6 +1814,22 @@ lbool Solver::search(int nof_conflicts) {
 
             lastLearntClause = CRef_Undef;
             Lit next = lit_Undef;
+            if(assumptionLevel) {
+                if(decisionLevel() == 0) {
+                    // All the assumptions at level 1, propagated together by the next iteration:
+                    newDecisionLevel();
+                    for(int i = 0; i < assumptions.size(); i++) {
+                        Lit p = assumptions[i];
+                        if(value(p) == l_False) {
+                            analyzeFinal(~p, conflict);
+                            return l_False;
+                        }
+                        if(value(p) == l_Undef)
+                            uncheckedEnqueue(p);
+                    }
+                    continue;
+                }
+            } else
             while(decisionLevel() < assumptions.size()) {
                 // Perform user provided assumption:
                 Lit p = assumptions[decisionLevel()];
@@ -1736,6 +1900,18 @@ void Solver::printIncrementalStats() {
     printf("c nb learnts size 1     : %"
     PRIu64
     "\n", stats[nbUn]);
+    printf("c nb vivified learnts   : %"
+    PRIu64
+    "\n", stats[nbVivified]);
+    printf("c restarts luby/LBD/blocked : %" PRIu64 " / %" PRIu64 " / %" PRIu64 "\n",
+           stats[lubyRestarts], stats[lbdRestarts], stats[nbstopsrestarts]);
+    printf("c watchers / blocker hits   : %" PRIu64 " / %" PRIu64 "\n", stats[watchVisits], stats[blockerHits]);
+    printf("c binary / long propagations: %" PRIu64 " / %" PRIu64 "\n", stats[binPropagations], stats[longPropagations]);
+    printf("c garbage collections   : %" PRIu64 " (%" PRIu64 " bytes)\n", stats[nbGarbageCollections], stats[garbageBytes]);
+    printf("c learnts by LBD        :");
+    for(int i = 1; i < lbdHistogramSize; i++)
+        printf(" %" PRIu64, stats[lbdHistogram + i]);
+    printf("\n");
 
     printf("c conflicts             : %"
     PRIu64
@@ -1787,6 +1963,7 @@ lbool Solver::solve_(bool do_simp, bool turn_off_simp) // Parameters are useless
     }
     model.clear();
     conflict.clear();
+    assumptionLevel = bulkAssumptions > 0 && assumptions.size() >= bulkAssumptions;
     double curTime = cpuTime();
 
     solves++;
@@ -1961,6 +2138,56 @@ void Solver::toDimacs(FILE *f, const vec <Lit> &assumps) {
 }
 
 
+//=================================================================================================
+// Exporting learnt clauses (checkpoints):
+
+struct learntLBD_lt {
+    ClauseAllocator &ca;
+
+    learntLBD_lt(ClauseAllocator &ca_) : ca(ca_) {}
+
+    bool operator()(CRef x, CRef y) {
+        if(ca[x].lbd() != ca[y].lbd()) return ca[x].lbd() < ca[y].lbd();
+        return ca[x].size() < ca[y].size();
+    }
+};
+
+
+void Solver::learntClauses(vec <vec <Lit> > &out, Var maxVar, unsigned int maxLBD, int max) {
+    if(!ok) {
+        out.push();
+        return;
+    }
+    int rootEnd = trail_lim.size() == 0 ? trail.size() : trail_lim[0];
+    for(int i = 0; i < rootEnd; i++)
+        if(var(trail[i]) < maxVar) {
+            out.push();
+            out.last().push(trail[i]);
+        }
+
+    vec <CRef> candidates;
+    for(int k = 0; k < 2; k++) {
+        vec <CRef> &cs = k == 0 ? learnts : permanentLearnts;
+        for(int i = 0; i < cs.size(); i++) {
+            Clause &c = ca[cs[i]];
+            if(c.mark() != 0 || c.lbd() > maxLBD || satisfied(c)) continue;
+            int j = 0;
+            while(j < c.size() && var(c[j]) < maxVar) j++;
+            if(j == c.size()) candidates.push(cs[i]);
+        }
+    }
+    sort(candidates, learntLBD_lt(ca));
+
+    for(int i = 0; i < candidates.size() && i < max; i++) {
+        Clause &c = ca[candidates[i]];
+        out.push();
+        for(int j = 0; j < c.size(); j++)
+            if(value(c[j]) != l_False)
+                out.last().push(c[j]);
+    }
+}
+
+
 //=================================================================================================
 // Garbage Collection methods:
 
@@ -2018,8 +2245,10 @@ void Solver::garbageCollect() {
     ClauseAllocator to(ca.size() - ca.wasted());
     relocAll(to);
     if(verbosity >= 2)
-        printf("|  Garbage collection:   %12d bytes => %12d bytes             |\n",
-               ca.size() * ClauseAllocator::Unit_Size, to.size() * ClauseAllocator::Unit_Size);
+        printf("|  Garbage collection:   %12" PRIu64" bytes => %12" PRIu64" bytes             |\n",
+               (uint64_t)ca.size() * ClauseAllocator::Unit_Size, (uint64_t)to.size() * ClauseAllocator::Unit_Size);
+    stats[nbGarbageCollections]++;
+    stats[garbageBytes] += (uint64_t)(ca.size() - to.size()) * ClauseAllocator::Unit_Size;
     to.moveTo(ca);
 }
 
@@ -87,10 +87,38 @@ enum CoreStats {
   learnts_literals,
   max_literals,
   tot_literals,
-  noDecisionConflict
+  noDecisionConflict,
+  nbVivified,
+  watchVisits,          // long clause watchers visited by propagate()
+  blockerHits,          // ... of which skipped because their blocker was true
+  binPropagations,      // literals implied by a binary clause
+  longPropagations,     // literals implied by a longer clause
+  nbGarbageCollections,
+  garbageBytes,         // bytes reclaimed by garbageCollect()
+  lubyRestarts,
+  lbdRestarts,          // dynamic restarts (lbdQueue); blocked ones are nbstopsrestarts
+  lbdHistogram          // first of lbdHistogramSize counters: learnt clauses by LBD
 } ;
 
-#define coreStatsSize 24
+#define lbdHistogramSize 16 // the last bucket holds LBD >= lbdHistogramSize - 1
+#define coreStatsSize (lbdHistogram + lbdHistogramSize)
+//=================================================================================================
+// TargetVars -- packed set of variables, one bit each, read by 'pickBranchLit':
+
+class TargetVars {
+    vec<uint64_t> bits;
+    int n;
+public:
+    TargetVars() : n(0) {}
+    int  size      () const { return n; }
+    // Adds variables [size(), size) to the universe, outside the set.
+    void growTo    (int size) { if (size > n) { n = size; bits.growTo((n + 63) >> 6, 0); } }
+    void insert    (Var v)    { assert(v < n); bits[v >> 6] |= (uint64_t) 1 << (v & 63); }
+    // False for the variables beyond 'size'.
+    bool has       (Var v) const { return v < n && ((bits[v >> 6] >> (v & 63)) & 1); }
+    void copyTo    (TargetVars& copy) const { bits.copyTo(copy.bits); copy.n = n; }
+};
+
 //=================================================================================================
 // Solver -- the main class:
 
@@ -101,6 +129,7 @@ class Solver : public Clone {
 public:
 
 	vec<lbool> _user_phase_saving;
+	TargetVars _target_vars; // Variables decided to the optimum (TorcOpenWbo's optimistic polarity).
     // Constructor/Destructor:
     //
     Solver();
@@ -166,6 +195,10 @@ public:
     int     nLearnts   ()      const;       // The current number of learnt clauses.
     int     nVars      ()      const;       // The current number of variables.
     int     nFreeVars  ()      ;
+    // Root level units and learnt clauses of LBD at most 'maxLBD' (best LBD first, at most 'max'
+    // clauses) over the variables below 'maxVar'. Literals false at the root level are dropped, and a
+    // contradictory solver gives the empty clause.
+    void    learntClauses(vec<vec<Lit> >& out, Var maxVar, unsigned int maxLBD, int max);
 
     inline char valuePhase(Var v) {return polarity[v];}
 
@@ -234,6 +267,12 @@ public:
     // Constant for Memory managment
     double    garbage_frac;       // The fraction of wasted memory allowed before a garbage collection is triggered.
 
+    // Assumptions
+    int       bulkAssumptions;    // From this many assumptions, they all share decision level 1 (0 = never).
+
+    // Inprocessing
+    int       vivifyInterval;     // Conflicts between two vivifications of the learnt clauses (0 = never).
+
     // Certified UNSAT ( Thanks to Marijn Heule
     // New in 2016 : proof in DRAT format, possibility to use binary output
     FILE*               certifiedOutput;
@@ -285,6 +324,14 @@ protected:
     bool randomize_on_restarts, fixed_randomize_on_restarts, newDescent;
     uint32_t randomDescentAssignments;
     bool forceUnsatOnNewDescent;
+    // TorcOpenWbo's polarity strategy, read once from Torc by the constructor.
+    bool polOptimistic, polConservative;
+    // The assumptions of the running call are all assigned at decision level 1 ('bulkAssumptions'):
+    // they are propagated in one pass, restarts go back to level 1 and a conflict at that level
+    // ends the call.
+    bool assumptionLevel;
+    // Next vivification ('vivifyInterval'), and propagations when the last one ended.
+    uint64_t nextVivify, vivifyProps;
     // Helper structures:
     //
     struct VarData { CRef reason; int level; };
@@ -410,10 +457,13 @@ protected:
     void     cancelUntil      (int level);                                             // Backtrack until a certain level.
     void     analyze          (CRef confl, vec<Lit>& out_learnt, vec<Lit> & selectors, int& out_btlevel,unsigned int &nblevels,unsigned int &szWithoutSelectors);    // (bt = backtrack)
     void     analyzeFinal     (Lit p, vec<Lit>& out_conflict);                         // COULD THIS BE IMPLEMENTED BY THE ORDINARIY "analyze" BY SOME REASONABLE GENERALIZATION?
+    void     analyzeFinal     (CRef confl, vec<Lit>& out_conflict);                    // Same, for a conflict among the assumptions.
+    void     analyzeFinalMarked(int marked, vec<Lit>& out_conflict);
     bool     litRedundant     (Lit p, uint32_t abstract_levels);                       // (helper method for 'analyze()')
     lbool    search           (int nof_conflicts);                                     // Search for a given number of conflicts.
     virtual lbool    solve_           (bool do_simp = true, bool turn_off_simp = false);                                                      // Main solve method (assumptions given in 'assumptions').
     virtual void     reduceDB         ();                                              // Reduce the set of learnt clauses.
+    bool     vivifyLearnts    ();                                              // Shorten the good learnt clauses by propagation (at level 0).
     void     removeSatisfied  (vec<CRef>& cs);                                         // Shrink 'cs' to contain only non-satisfied clauses.
     void     rebuildOrderHeap ();
 
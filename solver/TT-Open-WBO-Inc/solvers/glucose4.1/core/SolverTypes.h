@@ -176,7 +176,12 @@ class Clause {
 #endif
     }  header;
 
+#ifdef GLUCOSE_ARENA64
+    // A 64-bit relocation spans data[0] and data[1] (see ClauseAllocator::clauseWord32Size).
+    union { Lit lit; float act; uint32_t abs; } data[0];
+#else
     union { Lit lit; float act; uint32_t abs; CRef rel; } data[0];
+#endif
 
     friend class ClauseAllocator;
 
@@ -234,8 +239,13 @@ public:
     const Lit&   last        ()      const   { return data[header.size-1].lit; }
 
     bool         reloced     ()      const   { return header.reloced; }
+#ifdef GLUCOSE_ARENA64
+    CRef         relocation  ()      const   { return (CRef)data[0].abs | ((CRef)data[1].abs << 32); }
+    void         relocate    (CRef c)        { header.reloced = 1; data[0].abs = (uint32_t)c; data[1].abs = (uint32_t)(c >> 32); }
+#else
     CRef         relocation  ()      const   { return data[0].rel; }
     void         relocate    (CRef c)        { header.reloced = 1; data[0].rel = c; }
+#endif
 
     // NOTE: somewhat unsafe to change the clause in-place! Must manually call 'calcAbstraction' afterwards for
     //       subsumption operations to behave correctly.
@@ -280,11 +290,15 @@ public:
     class ClauseAllocator : public RegionAllocator<uint32_t>
     {
         static int clauseWord32Size(int size, int extra_size){
+#ifdef GLUCOSE_ARENA64
+            // Keep room for the two words of a relocation, even for unit clauses.
+            if (size + extra_size < 2) return (sizeof(Clause) + 2 * sizeof(Lit)) / sizeof(uint32_t);
+#endif
             return (sizeof(Clause) + (sizeof(Lit) * (size + extra_size))) / sizeof(uint32_t); }
     public:
         bool extra_clause_field;
 
-        ClauseAllocator(uint32_t start_cap) : RegionAllocator<uint32_t>(start_cap), extra_clause_field(false){}
+        ClauseAllocator(Ref start_cap) : RegionAllocator<uint32_t>(start_cap), extra_clause_field(false){}
         ClauseAllocator() : extra_clause_field(false){}
 
         void moveTo(ClauseAllocator& to){
@@ -24,38 +24,76 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #include "mtl/XAlloc.h"
 #include "mtl/Vec.h"
 
+#ifdef GLUCOSE_ARENA64
+#include <sys/mman.h>
+#include <unistd.h>
+
+// GiB of address space reserved by each clause arena ('make ARENA64_RESERVE=<GiB>').
+#ifndef GLUCOSE_ARENA64_RESERVE
+#define GLUCOSE_ARENA64_RESERVE 64
+#endif
+#endif
+
 namespace Glucose {
 
 //=================================================================================================
 // Simple Region-based memory allocator:
+//
+// With GLUCOSE_ARENA64 the references are 64 bits wide and the region lives in address space
+// reserved once with mmap: growing it only commits more pages of the reservation, so the clauses
+// are never copied and the region is not limited to 2^32 units.
+//
+// The reservation is GLUCOSE_ARENA64_RESERVE GiB per arena, and every solver copy has its own:
+// each worker of the ParallelSolver, each clone of a scenario, and for a moment the target arena
+// of a garbage collection. It is address space only (PROT_NONE, MAP_NORESERVE) until the region
+// grows into it, but it counts against 'ulimit -v'. When mmap refuses it, the reservation is
+// halved until it fits, and only then is the formula too large.
 
 template<class T>
 class RegionAllocator
 {
-    T*        memory;
-    uint32_t  sz;
-    uint32_t  cap;
-    uint32_t  wasted_;
-
-    void capacity(uint32_t min_cap);
-
  public:
     // TODO: make this a class for better type-checking?
+#ifdef GLUCOSE_ARENA64
+    typedef uint64_t Ref;
+    static const Ref Ref_Undef = UINT64_MAX;
+#else
     typedef uint32_t Ref;
     enum { Ref_Undef = UINT32_MAX };
+#endif
     enum { Unit_Size = sizeof(uint32_t) };
 
+ private:
+    T*        memory;
+    Ref       sz;
+    Ref       cap;
+    Ref       wasted_;
+#ifdef GLUCOSE_ARENA64
+    Ref       reserved; // Units of address space reserved at 'memory'.
+
+    void reserve(Ref min_cap);
+    void release() { if (memory != NULL) munmap(memory, sizeof(T)*reserved); }
+#else
+    void release() { if (memory != NULL) ::free(memory); }
+#endif
+
+    void capacity(Ref min_cap);
+
+ public:
+#ifdef GLUCOSE_ARENA64
+    explicit RegionAllocator(Ref start_cap = 1024*1024) : memory(NULL), sz(0), cap(0), wasted_(0), reserved(0){ capacity(start_cap); }
+#else
     explicit RegionAllocator(uint32_t start_cap = 1024*1024) : memory(NULL), sz(0), cap(0), wasted_(0){ capacity(start_cap); }
+#endif
     ~RegionAllocator()
     {
-        if (memory != NULL)
-            ::free(memory);
+        release();
     }
 
 
-    uint32_t size      () const      { return sz; }
-    uint32_t getCap    () const      { return cap;}
-    uint32_t wasted    () const      { return wasted_; }
+    Ref      size      () const      { return sz; }
+    Ref      getCap    () const      { return cap;}
+    Ref      wasted    () const      { return wasted_; }
 
     Ref      alloc     (int size); 
     void     free      (int size)    { wasted_ += size; }
@@ -70,22 +108,32 @@ class RegionAllocator
         return  (Ref)(t - &memory[0]); }
 
     void     moveTo(RegionAllocator& to) {
-        if (to.memory != NULL) ::free(to.memory);
+        to.release();
         to.memory = memory;
         to.sz = sz;
         to.cap = cap;
         to.wasted_ = wasted_;
+#ifdef GLUCOSE_ARENA64
+        to.reserved = reserved;
+        reserved = 0;
+#endif
 
         memory = NULL;
         sz = cap = wasted_ = 0;
     }
 
     void copyTo(RegionAllocator& to) const {
+#ifdef GLUCOSE_ARENA64
+        // Only the used part is copied; the target keeps its own reservation.
+        to.capacity(sz);
+        memcpy(to.memory,memory,sizeof(T)*sz);
+#else
      //   if (to.memory != NULL) ::free(to.memory);
         to.memory = (T*)xrealloc(to.memory, sizeof(T)*cap);
         memcpy(to.memory,memory,sizeof(T)*cap);        
-        to.sz = sz;
         to.cap = cap;
+#endif
+        to.sz = sz;
         to.wasted_ = wasted_;
     }
 
@@ -93,6 +141,47 @@ class RegionAllocator
 
 };
 
+#ifdef GLUCOSE_ARENA64
+template<class T>
+const typename RegionAllocator<T>::Ref RegionAllocator<T>::Ref_Undef;
+
+template<class T>
+void RegionAllocator<T>::reserve(Ref min_cap)
+{
+    // Reserve without committing, halved while the address space refuses it.
+    size_t bytes = (size_t)GLUCOSE_ARENA64_RESERVE << 30;
+    while (bytes / sizeof(T) < min_cap) bytes <<= 1;
+    for (;;){
+        void* mem = mmap(NULL, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mem != MAP_FAILED){
+            memory = (T*)mem;
+            reserved = bytes / sizeof(T);
+            return; }
+        bytes >>= 1;
+        if (bytes / sizeof(T) < min_cap)
+            throw OutOfMemoryException();
+    }
+}
+
+template<class T>
+void RegionAllocator<T>::capacity(Ref min_cap)
+{
+    if (cap >= min_cap) return;
+    if (memory == NULL) reserve(min_cap);
+    if (min_cap > reserved) throw OutOfMemoryException();
+
+    // Same growth factor as below, rounded to whole pages and committed in place:
+    Ref page = sysconf(_SC_PAGESIZE) / sizeof(T);
+    Ref new_cap = cap + (((cap >> 1) + (cap >> 3) + 2) & ~1);
+    if (new_cap < min_cap) new_cap = min_cap;
+    new_cap = (new_cap + page - 1) / page * page;
+    if (new_cap > reserved) new_cap = reserved;
+
+    if (mprotect(memory, sizeof(T)*new_cap, PROT_READ | PROT_WRITE) != 0)
+        throw OutOfMemoryException();
+    cap = new_cap;
+}
+#else
 template<class T>
 void RegionAllocator<T>::capacity(uint32_t min_cap)
 {
@@ -114,6 +203,7 @@ void RegionAllocator<T>::capacity(uint32_t min_cap)
     assert(cap > 0);
     memory = (T*)xrealloc(memory, sizeof(T)*cap);
 }
+#endif
 
 
 template<class T>
@@ -124,7 +214,7 @@ RegionAllocator<T>::alloc(int size)
     assert(size > 0);
     capacity(sz + size);
 
-    uint32_t prev_sz = sz;
+    Ref prev_sz = sz;
     sz += size;
     
     // Handle overflow:
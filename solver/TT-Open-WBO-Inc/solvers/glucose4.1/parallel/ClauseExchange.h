@@ -0,0 +1,106 @@
+/*************************************************************************************[ClauseExchange.h]
+ Learnt clauses shared by the workers of a parallel SAT call (see ParallelSolver.h), in the spirit
+ of the clause buffer of Glucose-Syrup but without locks.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ associated documentation files (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **************************************************************************************************/
+
+#ifndef Glucose_ClauseExchange_h
+#define Glucose_ClauseExchange_h
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "core/SolverTypes.h"
+
+namespace Glucose {
+
+//=================================================================================================
+// ClauseExchange -- one ring of clauses per worker, written by that worker only and read by every
+// other one through its own cursor. A reader that falls more than a ring behind loses the clauses
+// it missed, which is harmless: they are only learnt clauses.
+
+class ClauseExchange {
+public:
+    // Longest clause that can be published.
+    static const int maxSize = 64;
+
+    explicit ClauseExchange(int workers) : winner(-1) {
+        for (int i = 0; i < workers; i++)
+            rings.emplace_back(new Ring());
+    }
+
+    int workers() const { return rings.size(); }
+
+    // Called by the thread of 'worker' only.
+    void publish(int worker, const Lit *lits, int size, unsigned lbd) {
+        Ring &r = *rings[worker];
+        uint64_t h = r.head.load(std::memory_order_relaxed);
+        r.words[h % ringSize].store((size << 8) | (lbd < 255 ? lbd : 255), std::memory_order_relaxed);
+        for (int i = 0; i < size; i++)
+            r.words[(h + 1 + i) % ringSize].store(toInt(lits[i]), std::memory_order_relaxed);
+        r.head.store(h + 1 + size, std::memory_order_release);
+    }
+
+    // Reads the clause of 'from' at 'cursor' and moves the cursor past it. Returns false when
+    // there is none to read.
+    bool next(int from, uint64_t &cursor, vec<Lit> &clause, unsigned &lbd) {
+        Ring &r = *rings[from];
+        for (;;) {
+            uint64_t h = r.head.load(std::memory_order_acquire);
+            if (cursor == h)
+                return false;
+            if (h - cursor > ringSize - maxSize - 1) {
+                cursor = h; // overwritten
+                return false;
+            }
+            uint32_t header = r.words[cursor % ringSize].load(std::memory_order_relaxed);
+            int size = header >> 8;
+            lbd = header & 255;
+            if (size <= maxSize) {
+                clause.clear();
+                for (int i = 0; i < size; i++)
+                    clause.push(toLit(r.words[(cursor + 1 + i) % ringSize].load(std::memory_order_relaxed)));
+            }
+            // The writer may have gone round the ring while we were reading.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (size > maxSize || r.head.load(std::memory_order_relaxed) - cursor > ringSize - maxSize - 1) {
+                cursor = r.head.load(std::memory_order_acquire);
+                return false;
+            }
+            cursor += 1 + size;
+            return true;
+        }
+    }
+
+    // Worker that answered first, -1 while they all search.
+    std::atomic<int> winner;
+
+private:
+    static const uint64_t ringSize = 1 << 16; // words
+
+    struct Ring {
+        Ring() : head(0), words(ringSize) {}
+        std::atomic<uint64_t> head; // words written so far
+        std::vector<std::atomic<uint32_t> > words;
+    };
+    std::vector<std::unique_ptr<Ring> > rings;
+};
+
+}
+
+#endif
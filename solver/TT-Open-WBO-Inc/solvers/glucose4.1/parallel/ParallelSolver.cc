@@ -0,0 +1,243 @@
+/************************************************************************************[ParallelSolver.cc]
+ Several Glucose workers on one SAT call, sharing their low LBD learnt clauses.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ associated documentation files (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **************************************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "parallel/ParallelSolver.h"
+
+using namespace Glucose;
+
+//=================================================================================================
+// Copy and diversification:
+
+ParallelSolver::ParallelSolver(const ParallelSolver &s) :
+    Solver(s)
+  , threads(1)
+  , warmupConflicts(s.warmupConflicts)
+  , syncConflicts(s.syncConflicts)
+  , exchange(NULL)
+  , id(-1)
+  , importing(false)
+{
+    s._user_phase_saving.copyTo(_user_phase_saving);
+    s._target_vars.copyTo(_target_vars);
+}
+
+
+void ParallelSolver::diversify(int i) {
+    if (i == 0)
+        return;
+    // Never 0, see 'drand'.
+    random_seed = random_seed + 104729.0 * i;
+    randomizeFirstDescent = i % 2 == 1;
+    luby_restart = i % 4 == 3;
+    // Some workers ignore the polarity of the best model (TorcOpenWbo's conservative polarity).
+    if (i % 3 == 2)
+        _user_phase_saving.clear();
+}
+
+
+//=================================================================================================
+// Parallel search:
+
+lbool ParallelSolver::solveParallel(const vec<Lit> &assumps) {
+    if (threads <= 1)
+        return solveLimited(assumps);
+
+    // Most calls are easy: copying the solver is only worth it for the others.
+    int64_t budget = conflict_budget;
+    if (warmupConflicts > 0) {
+        conflict_budget = budget < 0 ? conflicts + warmupConflicts
+                                     : std::min<int64_t>(budget, conflicts + warmupConflicts);
+        lbool res = solveLimited(assumps);
+        conflict_budget = budget;
+        if (res != l_Undef || !withinBudget())
+            return res;
+    }
+
+    ClauseExchange shared(threads);
+    std::vector<std::unique_ptr<ParallelSolver> > workers;
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back(new ParallelSolver(*this));
+        ParallelSolver &w = *workers.back();
+        w.diversify(i);
+        w.conflict_budget = budget < 0 ? -1 : budget - conflicts;
+        w.exchange = &shared;
+        w.id = i;
+        w.cursors.assign(threads, 0);
+    }
+
+    std::vector<lbool> results(threads, l_Undef);
+    int winner = -1;
+    if (syncConflicts == 0) {
+        std::atomic<int> done(0);
+        std::vector<std::thread> pool;
+        for (int i = 0; i < threads; i++)
+            pool.emplace_back([&, i]() {
+                results[i] = workers[i]->solveLimited(assumps);
+                int none = -1;
+                if (results[i] != l_Undef)
+                    shared.winner.compare_exchange_strong(none, i);
+                done++;
+            });
+
+        // Wait for an answer, the budget of every worker, or an interruption of this solver.
+        while (shared.winner.load() < 0 && done.load() < threads && !asynch_interrupt)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        for (int i = 0; i < threads; i++)
+            workers[i]->interrupt();
+        for (std::thread &t : pool)
+            t.join();
+        winner = shared.winner.load();
+    } else {
+        std::vector<int64_t> limits(threads);
+        for (int i = 0; i < threads; i++)
+            limits[i] = workers[i]->conflict_budget;
+        for (;;) {
+            std::atomic<int> done(0);
+            std::vector<std::thread> pool;
+            for (int i = 0; i < threads; i++) {
+                ParallelSolver &w = *workers[i];
+                if (limits[i] >= 0 && (int64_t) w.conflicts >= limits[i])
+                    continue;
+                int64_t end = w.conflicts + syncConflicts;
+                w.conflict_budget = limits[i] < 0 ? end : std::min(end, limits[i]);
+                pool.emplace_back([&, i]() {
+                    results[i] = workers[i]->solveLimited(assumps);
+                    done++;
+                });
+            }
+            // The barrier. Only an interruption of this solver cuts a round short.
+            while (done.load() < (int) pool.size() && !asynch_interrupt)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            if (asynch_interrupt)
+                for (int i = 0; i < threads; i++)
+                    workers[i]->interrupt();
+            for (std::thread &t : pool)
+                t.join();
+
+            for (int i = 0; i < threads && winner < 0; i++)
+                if (results[i] != l_Undef)
+                    winner = i;
+            if (winner >= 0 || pool.empty() || asynch_interrupt)
+                break;
+            for (int i = 0; i < threads; i++)
+                if (workers[i]->importRound())
+                    results[i] = l_False;
+            for (int i = 0; i < threads && winner < 0; i++)
+                if (results[i] != l_Undef)
+                    winner = i;
+            if (winner >= 0)
+                break;
+        }
+    }
+
+    lbool res = l_Undef;
+    for (int i = 0; i < threads; i++)
+        conflicts += workers[i]->conflicts;
+    if (winner >= 0) {
+        res = results[winner];
+        workers[winner]->model.copyTo(model);
+        workers[winner]->conflict.copyTo(conflict);
+        if (res == l_False && conflict.size() == 0)
+            ok = false;
+    }
+
+    // Keep what the workers shared for the next calls.
+    if (ok) {
+        exchange = &shared;
+        cursors.assign(threads, 0);
+        if (importRound())
+            ok = false;
+        exchange = NULL;
+    }
+    return res;
+}
+
+
+bool ParallelSolver::importRound() {
+    importing = true;
+    bool empty = parallelImportClauses();
+    importing = false;
+    return empty;
+}
+
+
+//=================================================================================================
+// Clause sharing, at decision level 0 (imports) and on learning (exports):
+
+bool ParallelSolver::parallelImportClauses() {
+    if (exchange == NULL || (syncConflicts > 0 && !importing))
+        return false;
+    assert(decisionLevel() == 0);
+    unsigned lbd;
+    for (int from = 0; from < exchange->workers(); from++) {
+        if (from == id)
+            continue;
+        while (exchange->next(from, cursors[from], imported, lbd)) {
+            // Simplify at level 0.
+            int j = 0;
+            bool satisfied = false;
+            for (int i = 0; i < imported.size() && !satisfied; i++) {
+                if (value(imported[i]) == l_True)
+                    satisfied = true;
+                else if (value(imported[i]) == l_Undef)
+                    imported[j++] = imported[i];
+            }
+            if (satisfied)
+                continue;
+            imported.shrink(imported.size() - j);
+            if (imported.size() == 0)
+                return true;
+            if (imported.size() == 1) {
+                uncheckedEnqueue(imported[0]);
+                continue;
+            }
+            CRef cr = ca.alloc(imported, true);
+            ca[cr].setLBD(lbd);
+            ca[cr].setOneWatched(false);
+            learnts.push(cr);
+            attachClause(cr);
+        }
+    }
+    return false;
+}
+
+
+void ParallelSolver::parallelExportUnaryClause(Lit p) {
+    if (exchange != NULL && id >= 0)
+        exchange->publish(id, &p, 1, 1);
+}
+
+
+void ParallelSolver::parallelExportClauseDuringSearch(Clause &c) {
+    if (exchange == NULL || id < 0 || c.size() > exportSize)
+        return;
+    // Permanent learnt clauses (chanseok strategy) have a low LBD but do not record it.
+    unsigned lbd = c.learnt() ? c.lbd() : 2;
+    if (lbd > exportLBD)
+        return;
+    Lit lits[exportSize];
+    for (int i = 0; i < c.size(); i++)
+        lits[i] = c[i];
+    exchange->publish(id, lits, c.size(), lbd);
+}
@@ -0,0 +1,90 @@
+/*************************************************************************************[ParallelSolver.h]
+ Several Glucose workers on one SAT call, sharing their low LBD learnt clauses (see
+ ClauseExchange.h), in the spirit of Glucose-Syrup.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ associated documentation files (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **************************************************************************************************/
+
+#ifndef Glucose_ParallelSolver_h
+#define Glucose_ParallelSolver_h
+
+#include <vector>
+
+#include "core/Solver.h"
+#include "parallel/ClauseExchange.h"
+
+namespace Glucose {
+
+//=================================================================================================
+// ParallelSolver -- a Glucose solver whose hard SAT calls use several threads. Each call first
+// runs alone for 'warmupConflicts' conflicts. If it is still undecided, the solver is copied
+// (clauses, learnt clauses, activities and polarities) into 'threads' diversified workers that
+// search under the same assumptions, one thread each. They exchange their unit and low LBD
+// learnt clauses; the first answer wins and the others are interrupted. This solver keeps the
+// clauses shared during the call for the next ones.
+//
+// With 'syncConflicts' other than 0 the call is deterministic: the workers search in rounds of
+// that many conflicts each, separated by a barrier. The clauses learnt in a round are imported
+// at the next barrier only, in the order of the workers, and among the workers that answered in
+// a round the one with the lowest id wins. The answer then depends on the conflicts of the
+// workers only, not on their speed.
+//
+// Clauses are added between calls only, as with the single threaded solver.
+
+class ParallelSolver : public Solver {
+public:
+    ParallelSolver() : threads(1), warmupConflicts(10000), syncConflicts(0), exchange(NULL), id(-1),
+                       importing(false) {}
+    // Copies 's' at decision level 0, including the polarity vectors of TorcOpenWbo.
+    ParallelSolver(const ParallelSolver &s);
+
+    virtual Clone *clone() const { return new ParallelSolver(*this); }
+
+    // Same contract as 'solveLimited': the conflict budget and 'interrupt' apply to the whole
+    // call. 'model' or 'conflict' hold the answer of the winning worker.
+    lbool solveParallel(const vec<Lit> &assumps);
+
+    int threads;            // workers of a hard call, this solver included
+    int warmupConflicts;    // conflicts before a call is hard
+    int syncConflicts;      // conflicts of a round of a deterministic call, 0 if free running
+
+    // Learnt clauses shared: units and clauses of LBD at most 'exportLBD' with at most
+    // 'exportSize' literals.
+    static const unsigned exportLBD = 3;
+    static const int exportSize = 30;
+
+protected:
+    virtual bool parallelImportClauses();
+    virtual void parallelExportUnaryClause(Lit p);
+    virtual void parallelExportClauseDuringSearch(Clause &c);
+
+private:
+    // Search settings of worker 'i' (worker 0 searches like this solver).
+    void diversify(int i);
+    // Deterministic calls: imports the clauses of the last round. Returns true if they hold the
+    // empty clause.
+    bool importRound();
+
+    ClauseExchange *exchange;    // of the running call, NULL between calls
+    int id;                      // of this worker in 'exchange', -1 if it only reads
+    std::vector<uint64_t> cursors; // per worker of 'exchange'
+    vec<Lit> imported;
+    bool importing;              // deterministic calls only import in 'importRound'
+};
+
+}
+
+#endif